@@ -0,0 +1,147 @@
+/*
+ * arena.c - region (arena) allocator on top of memlib (see arena.h)
+ *
+ * The chunks of an arena are consecutive mem_sbrk extents of its own
+ * region, so they form one contiguous range [base, end) and the bump
+ * pointer never has to skip to another chunk. Spilled objects are
+ * mm_malloc'ed with a link in front and kept on a list, newest first,
+ * so that a mark only has to remember the list head.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+
+#define ARENA_CHUNK (64 * 1024) /* bytes taken from memlib at a time */
+
+/* Link in front of a spilled object */
+typedef struct spill
+{
+	struct spill *next; /* next older spilled object */
+} spill_t;
+
+struct arena
+{
+	mem_region_t *region; /* where the chunks come from */
+	char *base;			  /* first byte of the chunks */
+	char *top;			  /* next free byte */
+	char *end;			  /* end of the chunks taken so far */
+	size_t spill;		  /* spill objects at least this big (0: never) */
+	spill_t *spills;	  /* spilled objects, newest first */
+};
+
+/* Round p up to a multiple of align (a power of two) */
+#define ALIGN_UP(p, align) \
+	((char *)(((uintptr_t)(p) + (align) - 1) & ~(uintptr_t)((align) - 1)))
+
+/*
+ * arena_grow - take whole chunks from the region until need more bytes
+ *     fit after a->end. Returns -1 if the region is full.
+ */
+static int arena_grow(arena_t *a, size_t need)
+{
+	mem_region_t *prev = mem_region_use(a->region);
+	size_t incr = (need + ARENA_CHUNK - 1) & ~(size_t)(ARENA_CHUNK - 1);
+	char *p = mem_sbrk((int)incr);
+
+	mem_region_use(prev);
+	if (p == (char *)-1)
+		return -1;
+	a->end = p + incr;
+	return 0;
+}
+
+arena_t *arena_create(size_t max, size_t spill)
+{
+	arena_t *a;
+	mem_region_t *prev;
+
+	if ((a = calloc(1, sizeof(arena_t))) == NULL)
+		return NULL;
+	if ((a->region = mem_region_create(max)) == NULL)
+	{
+		free(a);
+		return NULL;
+	}
+	prev = mem_region_use(a->region);
+	a->base = a->top = a->end = mem_heap_lo();
+	mem_region_use(prev);
+	a->spill = spill;
+	return a;
+}
+
+/*
+ * spill_alloc - allocate an object with mm_malloc and put it on the
+ *     spill list
+ */
+static void *spill_alloc(arena_t *a, size_t size, size_t align)
+{
+	spill_t *s;
+
+	if ((s = mm_malloc(sizeof(spill_t) + align + size)) == NULL)
+		return NULL;
+	s->next = a->spills;
+	a->spills = s;
+	return ALIGN_UP(s + 1, align);
+}
+
+void *arena_alloc(arena_t *a, size_t size, size_t align)
+{
+	char *p;
+
+	if (align == 0)
+		align = ALIGNMENT;
+	if (a->spill && size >= a->spill)
+		return spill_alloc(a, size, align);
+
+	p = ALIGN_UP(a->top, align);
+	if (p + size > a->end && arena_grow(a, p + size - a->end) < 0)
+		return NULL;
+	a->top = p + size;
+	return p;
+}
+
+arena_mark_t arena_save(arena_t *a)
+{
+	arena_mark_t mark;
+
+	mark.top = a->top;
+	mark.spills = a->spills;
+	return mark;
+}
+
+void arena_restore(arena_t *a, arena_mark_t mark)
+{
+	spill_t *s;
+
+	while (a->spills != mark.spills)
+	{
+		s = a->spills;
+		a->spills = s->next;
+		mm_free(s);
+	}
+	a->top = mark.top;
+}
+
+void arena_reset(arena_t *a)
+{
+	arena_mark_t empty = {a->base, NULL};
+
+	arena_restore(a, empty);
+}
+
+size_t arena_used(arena_t *a)
+{
+	return (size_t)(a->top - a->base);
+}
+
+void arena_destroy(arena_t *a)
+{
+	arena_reset(a);
+	mem_region_destroy(a->region);
+	free(a);
+}
@@ -0,0 +1,54 @@
+/*
+ * arena.h - region (arena) allocator for short-lived objects
+ *
+ * An arena hands out memory by bumping a pointer through chunks taken
+ * from its own memlib region. Objects are never freed one by one:
+ * arena_restore drops everything allocated since an arena_save, and
+ * arena_reset drops everything, keeping the chunks for the next use.
+ * Objects of at least the spill size go to mm_malloc instead, so that
+ * a few big ones don't grow the chunks for good; they are freed with
+ * the rest of the arena.
+ */
+#ifndef __ARENA_H_
+#define __ARENA_H_
+
+#include <stddef.h>
+
+typedef struct arena arena_t;
+
+/* A position in an arena, saved by arena_save for arena_restore */
+typedef struct
+{
+	char *top;	  /* bump pointer at the time of the save */
+	void *spills; /* newest spilled object at the time of the save */
+} arena_mark_t;
+
+/*
+ * Make an arena of at most max bytes of chunks. Objects of spill bytes
+ * or more are spilled to mm_malloc (0 never spills). Returns NULL if
+ * the region can't be mapped.
+ */
+arena_t *arena_create(size_t max, size_t spill);
+
+/*
+ * Allocate size bytes aligned to align (a power of two, or 0 for
+ * ALIGNMENT). Returns NULL when the arena is full.
+ */
+void *arena_alloc(arena_t *a, size_t size, size_t align);
+
+/* Save the current position; marks nest like a stack */
+arena_mark_t arena_save(arena_t *a);
+
+/* Drop everything allocated since mark was saved */
+void arena_restore(arena_t *a, arena_mark_t mark);
+
+/* Drop everything, keeping the chunks */
+void arena_reset(arena_t *a);
+
+/* Bytes of chunks in use (spilled objects not counted) */
+size_t arena_used(arena_t *a);
+
+/* Free the spilled objects and give the region back */
+void arena_destroy(arena_t *a);
+
+#endif /* __ARENA_H_ */
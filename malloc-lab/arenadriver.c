@@ -0,0 +1,274 @@
+/*
+ * arenadriver.c - Arena allocator vs. mm malloc on request-shaped traces
+ *
+ * Replays each trace once with mm_malloc/mm_realloc/mm_free and once
+ * with an arena (arena.c). In the arena replay a free only counts the
+ * live blocks down, and the arena is reset whenever none are left,
+ * i.e. at the end of every request of a trace like
+ * traces/requests-bal.rep. A realloc allocates a new object in the
+ * arena and copies the old one.
+ *
+ * For each trace we report the throughput of both replays (best of
+ * -r runs) and the peak memory each one used: the heap for mm, the
+ * arena chunks plus the heap of the spilled objects for the arena.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "arena.h"
+#include "config.h"
+#include "trace.h"
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXLINE 1024	   /* max string size */
+#define DEFAULT_RUNS 5	   /* timed runs per replay, best is kept (-r) */
+#define DEFAULT_SPILL 4096 /* spill objects this big to mm_malloc (-s) */
+
+/******************************
+ * The key compound data types
+ *****************************/
+
+/* The result of replaying a trace */
+typedef struct
+{
+	double secs; /* time of the best run */
+	size_t peak; /* peak bytes of memory used */
+	int resets;	 /* arena resets (requests) in a run */
+} arenastats_t;
+
+/********************
+ * Global variables
+ *******************/
+/* Directory where default tracefiles are found */
+static char tracedir[MAXLINE] = TRACEDIR;
+
+/* The request-shaped traces replayed by default */
+static char *default_tracefiles[] = {
+	"requests-bal.rep", NULL};
+
+/*********************
+ * Function prototypes
+ *********************/
+static void replay_mm(trace_t *trace, int runs, arenastats_t *stats);
+static void replay_arena(trace_t *trace, int runs, size_t spill,
+						 arenastats_t *stats);
+static void mm_reset(void);
+static void usage(void);
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+	int i, c;
+	char **tracefiles = NULL;	/* null-terminated array of trace file names */
+	int num_tracefiles = 0;		/* the number of traces in that array */
+	int runs = DEFAULT_RUNS;	/* timed runs per replay */
+	size_t spill = DEFAULT_SPILL; /* arena spill size */
+	trace_t *trace;
+	arenastats_t mm_stats, arena_stats;
+
+	while ((c = getopt(argc, argv, "f:t:r:s:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'f': /* Use one specific trace file only (relative to curr dir) */
+			num_tracefiles = 1;
+			if ((tracefiles = realloc(tracefiles, 2 * sizeof(char *))) == NULL)
+				unix_error("ERROR: realloc failed in main");
+			strcpy(tracedir, "./");
+			tracefiles[0] = strdup(optarg);
+			tracefiles[1] = NULL;
+			break;
+		case 't': /* Directory where the traces are located */
+			if (num_tracefiles == 1) /* ignore if -f already encountered */
+				break;
+			strcpy(tracedir, optarg);
+			if (tracedir[strlen(tracedir) - 1] != '/')
+				strcat(tracedir, "/"); /* path always ends with "/" */
+			break;
+		case 'r': /* Timed runs per replay */
+			if ((runs = atoi(optarg)) < 1)
+				app_error("-r must be at least 1");
+			break;
+		case 's': /* Spill size of the arena */
+			spill = (size_t)atol(optarg);
+			break;
+		case 'h': /* Print this message */
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	if (tracefiles == NULL)
+	{
+		tracefiles = default_tracefiles;
+		num_tracefiles = sizeof(default_tracefiles) / sizeof(char *) - 1;
+		printf("Using default tracefiles in %s\n", tracedir);
+	}
+
+	/* Initialize the simulated memory system in memlib.c */
+	mem_init();
+
+	printf("%-20s%8s%10s%8s%12s%10s%10s\n", "trace", "ops", "mm Kops",
+		   "mm KB", "arena Kops", "arena KB", "requests");
+	for (i = 0; i < num_tracefiles; i++)
+	{
+		trace = read_trace(tracedir, tracefiles[i]);
+		replay_mm(trace, runs, &mm_stats);
+		replay_arena(trace, runs, spill, &arena_stats);
+		printf("%-20s%8d%10.0f%8.0f%12.0f%10.0f%10d\n", tracefiles[i],
+			   trace->num_ops,
+			   trace->num_ops / 1e3 / mm_stats.secs, mm_stats.peak / 1024.0,
+			   trace->num_ops / 1e3 / arena_stats.secs,
+			   arena_stats.peak / 1024.0, arena_stats.resets);
+		free_trace(trace);
+	}
+
+	mem_deinit();
+	exit(0);
+}
+
+/*
+ * replay_mm - Replay the trace with mm malloc runs times, and keep the
+ *     fastest run
+ */
+static void replay_mm(trace_t *trace, int runs, arenastats_t *stats)
+{
+	traceop_t *op;
+	double start, secs;
+	int i, r;
+
+	stats->secs = 0;
+	stats->resets = 0;
+	for (r = 0; r < runs; r++)
+	{
+		mm_reset();
+		start = now();
+		for (i = 0; i < trace->num_ops; i++)
+		{
+			op = &trace->ops[i];
+			switch (op->type)
+			{
+			case ALLOC:
+				if ((trace->blocks[op->index] = mm_malloc(op->size)) == NULL)
+					app_error("mm_malloc failed in replay_mm");
+				break;
+			case REALLOC:
+				if ((trace->blocks[op->index] =
+						 mm_realloc(trace->blocks[op->index], op->size)) == NULL)
+					app_error("mm_realloc failed in replay_mm");
+				break;
+			case FREE:
+				mm_free(trace->blocks[op->index]);
+				break;
+			}
+		}
+		secs = now() - start;
+		if (stats->secs == 0 || secs < stats->secs)
+			stats->secs = secs;
+	}
+	stats->peak = mem_heap_peak();
+}
+
+/*
+ * replay_arena - Replay the trace with an arena runs times, resetting
+ *     it whenever no block is live, and keep the fastest run
+ */
+static void replay_arena(trace_t *trace, int runs, size_t spill,
+						 arenastats_t *stats)
+{
+	arena_t *arena;
+	traceop_t *op;
+	double start, secs;
+	size_t used, peak = 0;
+	int i, r, live;
+	char *p;
+
+	if ((arena = arena_create(MAX_HEAP, spill)) == NULL)
+		app_error("arena_create failed in replay_arena");
+
+	stats->secs = 0;
+	for (r = 0; r < runs; r++)
+	{
+		mm_reset(); /* the spilled objects */
+		live = 0;
+		stats->resets = 0;
+		start = now();
+		for (i = 0; i < trace->num_ops; i++)
+		{
+			op = &trace->ops[i];
+			switch (op->type)
+			{
+			case ALLOC:
+				if ((p = arena_alloc(arena, op->size, 0)) == NULL)
+					app_error("arena_alloc failed in replay_arena");
+				trace->blocks[op->index] = p;
+				trace->block_sizes[op->index] = op->size;
+				live++;
+				break;
+			case REALLOC:
+				if ((p = arena_alloc(arena, op->size, 0)) == NULL)
+					app_error("arena_alloc failed in replay_arena");
+				memcpy(p, trace->blocks[op->index],
+					   op->size < trace->block_sizes[op->index]
+						   ? op->size
+						   : trace->block_sizes[op->index]);
+				trace->blocks[op->index] = p;
+				trace->block_sizes[op->index] = op->size;
+				break;
+			case FREE:
+				if (--live == 0) /* end of a request */
+				{
+					used = arena_used(arena);
+					peak = (used > peak) ? used : peak;
+					arena_reset(arena);
+					stats->resets++;
+				}
+				break;
+			}
+		}
+		secs = now() - start;
+		if (stats->secs == 0 || secs < stats->secs)
+			stats->secs = secs;
+	}
+	stats->peak = peak + mem_heap_peak();
+	arena_destroy(arena);
+}
+
+/*
+ * mm_reset - Start over with an empty mm heap
+ */
+static void mm_reset(void)
+{
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in mm_reset");
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+	fprintf(stderr, "Usage: arenadriver [-h] [-f <file>] [-t <dir>] "
+					"[-r <runs>] [-s <bytes>]\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
+	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-r <runs>  Timed runs per replay (default %d).\n",
+			DEFAULT_RUNS);
+	fprintf(stderr, "\t-s <bytes> Spill objects this big to mm_malloc "
+					"(default %d, 0 never).\n", DEFAULT_SPILL);
+	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+}
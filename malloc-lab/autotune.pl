@@ -0,0 +1,209 @@
+#!/usr/bin/perl
+#
+# autotune.pl - search the compile-time MM_* settings of mm.c for the
+#               configuration that scores best on a trace set
+#
+# usage: autotune.pl [-s random|grid|local] [-n <trials>] [-S <seed>]
+#                    [-w <objective>] [-o <file>] [-- <mdriver args>]
+#
+# Each trial builds mdriver-tune with "make MMFLAGS_tune=...", runs it
+# with --json and scores the result. By default the score is the
+# perfindex that mdriver prints (UTIL_WEIGHT * util + the capped
+# throughput term); -w util=0.5,tutil=0.3,thru=0.2 scores a weighted
+# sum of the average peak utilization, the average time-averaged
+# utilization and the throughput relative to AVG_LIBC_THRUPUT (capped
+# at 1) instead, each in [0, 1].
+#
+# Search strategies, all reproducible for a given -S seed:
+#   random  sample -n configurations uniformly (default)
+#   grid    try every configuration (-n is ignored)
+#   local   -n random samples, then coordinate descent from the best:
+#           change one setting at a time while that improves the score
+#
+# The best configuration is written to tune.mk (-o) as a "tuned"
+# variant, which the Makefile picks up: make mdriver-tuned.
+#
+use strict;
+use Getopt::Std;
+use JSON::PP;
+
+# The settings and the values tried for each (see the top of mm.c).
+# The first value of each is what mm.c uses by default.
+my @space = (
+    [ PLACEMENT => qw(BINS FIRST NEXT BEST TLSF) ],
+    [ CHUNKSIZE => qw(4096 1024 2048 8192 16384 65536) ],
+    [ GROWTH => qw(ADAPTIVE CHUNK EXACT) ],
+    [ GROW_CAP => qw(65536 16384 262144) ],
+    [ MIN_SPLIT => qw(16 24 32 48 64) ],
+    [ SIZE_CLASSES => ('none', '16,24,32,48,64,96,128',
+                       '16,32,64,128,256,512,1024,2048,4096') ],
+    [ HDR_BYTES => qw(4 8) ],
+);
+
+my %opts;
+getopts('s:n:S:w:o:h', \%opts) or usage();
+usage() if $opts{h};
+my $strategy = $opts{s} || 'random';
+my $trials = $opts{n} || 30;
+my $seed = defined $opts{S} ? $opts{S} : 1;
+my $outfile = $opts{o} || 'tune.mk';
+my @driver_args = @ARGV;
+my %weights = parse_weights($opts{w}) if $opts{w};
+usage() unless $strategy =~ /^(random|grid|local)$/;
+
+srand($seed);
+my (%seen, $best, $best_score);
+$best_score = -1;
+
+if ($strategy eq 'grid') {
+    my @configs = ([]);
+    foreach my $dim (@space) {
+        my (undef, @vals) = @$dim;
+        @configs = map { my $c = $_; map { [@$c, $_] } @vals } @configs;
+    }
+    printf "Grid search over %d configurations\n", scalar @configs;
+    trial($_) foreach @configs;
+} else {
+    trial([ map { $_->[1] } @space ]);    # the current defaults
+    for (my $i = 1; $i < $trials; $i++) {
+        trial([ map { my (undef, @v) = @$_; $v[int(rand(@v))] } @space ]);
+    }
+    if ($strategy eq 'local') {
+        # Coordinate descent: keep changing one setting while it helps
+        my $improved = 1;
+        while ($improved) {
+            $improved = 0;
+            foreach my $d (0 .. $#space) {
+                my (undef, @vals) = @{$space[$d]};
+                foreach my $v (@vals) {
+                    my @c = @$best;
+                    $c[$d] = $v;
+                    $improved = 1 if trial(\@c) > 0;
+                }
+            }
+        }
+    }
+}
+
+die "No configuration ran successfully\n" unless $best;
+my $flags = mmflags($best);
+printf "\nBest score %.3f: %s\n", $best_score, $flags;
+open my $out, '>', $outfile or die "Cannot create $outfile: $!\n";
+print $out "# Written by autotune.pl -s $strategy -n $trials -S $seed",
+    ($opts{w} ? " -w $opts{w}" : ''), "\n";
+printf $out "# score %.3f\n", $best_score;
+print $out "VARIANTS += tuned\n";
+print $out "MMFLAGS_tuned = $flags\n";
+close $out;
+print "Wrote $outfile; build it with \"make mdriver-tuned\"\n";
+unlink 'mdriver-tune', 'mm-tune.o', 'tune.json';
+exit 0;
+
+#
+# mmflags - the -D flags for a configuration
+#
+sub mmflags {
+    my ($config) = @_;
+    my @flags;
+    foreach my $d (0 .. $#space) {
+        my ($name, $val) = ($space[$d][0], $config->[$d]);
+        if ($name eq 'PLACEMENT') {
+            push @flags, $val eq 'TLSF' ? '-DMM_REALTIME'
+                                        : "-DMM_PLACEMENT=MM_PLACE_$val";
+        } elsif ($name eq 'GROWTH') {
+            push @flags, "-DMM_GROWTH=MM_GROW_$val";
+        } elsif ($name eq 'SIZE_CLASSES') {
+            push @flags, "-DMM_SIZE_CLASSES=$val" unless $val eq 'none';
+        } elsif ($name eq 'MIN_SPLIT') {
+            # The split threshold can't be below the minimum block
+            my $hdr = $config->[index_of('HDR_BYTES')];
+            push @flags, "-DMM_MIN_SPLIT=" . ($val < 4 * $hdr ? 4 * $hdr : $val);
+        } else {
+            push @flags, "-DMM_$name=$val";
+        }
+    }
+    return join ' ', @flags;
+}
+
+sub index_of {
+    my ($name) = @_;
+    foreach my $d (0 .. $#space) {
+        return $d if $space[$d][0] eq $name;
+    }
+    die "Unknown setting $name\n";
+}
+
+#
+# trial - build and score one configuration. Returns 1 if it is the
+#     new best, 0 if not, and -1 if it failed or was already tried.
+#
+sub trial {
+    my ($config) = @_;
+    my $flags = mmflags($config);
+    return -1 if $seen{$flags}++;
+
+    unlink 'mm-tune.o', 'mdriver-tune';
+    if (system("make -s mdriver-tune MMFLAGS_tune='$flags' >/dev/null 2>&1") != 0) {
+        print "build failed: $flags\n";
+        return -1;
+    }
+    unlink 'tune.json';
+    # A non-zero exit (e.g. from --compare) still leaves a report
+    system(join ' ', './mdriver-tune -a --json tune.json',
+           (map { quotemeta } @driver_args), '>/dev/null 2>&1');
+    my $score = score('tune.json');
+    if (!defined $score) {
+        print "failed: $flags\n";
+        return -1;
+    }
+    printf "%8.3f  %s\n", $score, $flags;
+    if ($score > $best_score) {
+        ($best, $best_score) = ([@$config], $score);
+        return 1;
+    }
+    return 0;
+}
+
+#
+# score - the objective for one mdriver --json report, or undef if the
+#     report is missing or some trace failed
+#
+sub score {
+    my ($file) = @_;
+    open my $in, '<', $file or return undef;
+    my $report = decode_json(do { local $/; <$in> });
+    close $in;
+
+    my @mm = grep { $_->{allocator} eq 'mm' } @{$report->{traces}};
+    return undef if !@mm || grep { !$_->{valid} } @mm;
+    return $report->{perfindex} unless %weights;
+
+    my ($util, $tutil, $ops, $secs) = (0, 0, 0, 0);
+    foreach my $t (@mm) {
+        $util += $t->{util};
+        $tutil += $t->{util_avg};
+        $ops += $t->{ops};
+        $secs += $t->{secs};
+    }
+    my $thru = $secs > 0 ? $ops / $secs / $report->{avg_libc_thruput} : 0;
+    $thru = 1 if $thru > 1;
+    return 100 * ($weights{util} * $util / @mm + $weights{tutil} * $tutil / @mm +
+                  $weights{thru} * $thru);
+}
+
+sub parse_weights {
+    my ($spec) = @_;
+    my %w = (util => 0, tutil => 0, thru => 0);
+    foreach my $term (split /,/, $spec) {
+        my ($k, $v) = split /=/, $term;
+        die "Unknown objective term '$k' (use util, tutil, thru)\n"
+            unless exists $w{$k} && defined $v;
+        $w{$k} = $v;
+    }
+    return %w;
+}
+
+sub usage {
+    die "usage: $0 [-s random|grid|local] [-n <trials>] [-S <seed>]\n",
+        "       [-w util=<w>,tutil=<w>,thru=<w>] [-o <file>] [-- <mdriver args>]\n";
+}
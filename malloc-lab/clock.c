@@ -1,5 +1,5 @@
 /* 
- * clock.c - Routines for using the cycle counters on x86, 
+ * clock.c - Routines for using the cycle counters on x86, x86-64,
  *           Alpha, and Sparc boxes.
  * 
  * Copyright (c) 2002, R. Bryant and D. O'Hallaron, All rights reserved.
@@ -8,10 +8,25 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <time.h>
 #include <sys/times.h>
 #include "clock.h"
 
+/* 
+ * mono_ns - read CLOCK_MONOTONIC_RAW in nanoseconds. Used as the
+ *     counter on boxes without a usable cycle counter, and as the
+ *     reference clock when calibrating the cycle counter.
+ */
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
 
 /******************************************************* 
  * Machine dependent functions 
@@ -71,6 +86,74 @@ double get_counter()
 }
 /* $end x86cyclecounter */
 
+#elif defined(__x86_64__)
+/*******************************************************
+ * x86-64 versions of start_counter() and get_counter()
+ *
+ * Uses the full 64-bit time stamp counter when the processor has an
+ * invariant TSC (constant rate, keeps ticking in deep C-states).
+ * lfence before rdtsc keeps earlier instructions from drifting past
+ * the start read; rdtscp followed by lfence keeps later instructions
+ * from starting before the end read. Without an invariant TSC we
+ * count nanoseconds of CLOCK_MONOTONIC_RAW instead, and mhz()
+ * calibrates to ~1000 "MHz".
+ *******************************************************/
+#include <cpuid.h>
+
+static uint64_t cyc_start = 0;
+static int use_tsc = -1;   /* -1 until has_invariant_tsc() is probed */
+
+/* Does the processor have rdtscp and an invariant TSC? */
+static int has_invariant_tsc(void)
+{
+    unsigned eax, ebx, ecx, edx;
+
+    if (__get_cpuid_max(0x80000000, NULL) < 0x80000007)
+	return 0;
+    if (!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) ||
+	!(edx & (1u << 27)))   /* rdtscp */
+	return 0;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+	return 0;
+    return (edx >> 8) & 1;     /* invariant TSC */
+}
+
+/* Read the counter at the start of a timed region */
+static inline uint64_t read_start(void)
+{
+    unsigned hi, lo;
+
+    if (!use_tsc)
+	return mono_ns();
+    asm volatile("lfence; rdtsc" : "=d" (hi), "=a" (lo) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Read the counter at the end of a timed region */
+static inline uint64_t read_end(void)
+{
+    unsigned hi, lo, aux;
+
+    if (!use_tsc)
+	return mono_ns();
+    asm volatile("rdtscp; lfence" : "=d" (hi), "=a" (lo), "=c" (aux) : : "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Record the current value of the cycle counter. */
+void start_counter()
+{
+    if (use_tsc < 0)
+	use_tsc = has_invariant_tsc();
+    cyc_start = read_start();
+}
+
+/* Return the number of cycles since the last call to start_counter. */
+double get_counter()
+{
+    return (double)(read_end() - cyc_start);
+}
+
 #elif defined(__alpha)
 
 /****************************************************
@@ -140,23 +223,20 @@ double get_counter()
  * counter routines. Newer models of sparcs (v8plus) have cycle
  * counters that can be accessed from user programs, but since there
  * are still many sparc boxes out there that don't support this, we
- * haven't provided a Sparc version here.
+ * haven't provided a Sparc version here. Instead the "cycles" are
+ * nanoseconds of CLOCK_MONOTONIC_RAW.
  ***************************************************************/
 
+static uint64_t cyc_start = 0;
+
 void start_counter()
 {
-    printf("ERROR: You are trying to use a start_counter routine in clock.c\n");
-    printf("that has not been implemented yet on this platform.\n");
-    printf("Please choose another timing package in config.h.\n");
-    exit(1);
+    cyc_start = mono_ns();
 }
 
 double get_counter() 
 {
-    printf("ERROR: You are trying to use a get_counter routine in clock.c\n");
-    printf("that has not been implemented yet on this platform.\n");
-    printf("Please choose another timing package in config.h.\n");
-    exit(1);
+    return (double)(mono_ns() - cyc_start);
 }
 #endif
 
@@ -195,10 +275,36 @@ double mhz_full(int verbose, int sleeptime)
 }
 /* $end mhz */
 
-/* Version using a default sleeptime */
+/* 
+ * mhz - Estimate the clock rate by spinning against CLOCK_MONOTONIC_RAW
+ *     for a few short windows instead of sleeping, and take the median.
+ */
+#define CALIBRATE_NS 10000000   /* length of one window (10 ms) */
+#define CALIBRATE_WINDOWS 5     /* number of windows */
+
 double mhz(int verbose)
 {
-    return mhz_full(verbose, 2);
+    double rates[CALIBRATE_WINDOWS], rate;
+    uint64_t start, now;
+    int i, j;
+
+    for (i = 0; i < CALIBRATE_WINDOWS; i++) {
+	start = mono_ns();
+	start_counter();
+	do {
+	    now = mono_ns();
+	} while (now - start < CALIBRATE_NS);
+	rate = get_counter() / (1e-3 * (now - start));
+
+	/* Insertion sort */
+	for (j = i; j > 0 && rates[j-1] > rate; j--)
+	    rates[j] = rates[j-1];
+	rates[j] = rate;
+    }
+    rate = rates[CALIBRATE_WINDOWS / 2];
+    if (verbose) 
+	printf("Processor clock rate ~= %.1f MHz\n", rate);
+    return rate;
 }
 
 /** Special counters that compensate for timer interrupt overhead */
@@ -9,7 +9,7 @@ double get_counter();
 /* Measure overhead for counter */
 double ovhd();
 
-/* Determine clock rate of processor (using a default sleeptime) */
+/* Determine clock rate of processor (calibrated against CLOCK_MONOTONIC_RAW) */
 double mhz(int verbose);
 
 /* Determine clock rate of processor, having more control over accuracy */
@@ -0,0 +1,329 @@
+/*
+ * compactdriver.c - Handle blocks with incremental compaction vs. mm malloc
+ *
+ * Replays each trace once with mm_malloc/mm_realloc/mm_free and once
+ * with mm_halloc/mm_hrealloc/mm_hfree. In the handle replay every free
+ * is followed by a call to mm_compact with a budget of -b nanoseconds,
+ * which slides handle blocks down over the free gaps and, at the end
+ * of each pass, gives the free tail of the heap back to memlib.
+ *
+ * Both replays fill every block with a byte of its id and check it
+ * before the block is freed, so a block the compaction moved wrong
+ * shows up as an error. For each trace we report the throughput of
+ * both replays, the peak heap and the heap size averaged over all ops,
+ * the number of compaction passes that reached the end of the heap, the
+ * longest single mm_compact call and how many calls took more than
+ * twice the budget. As a control, each mm_compact call is followed by a
+ * busy wait of one budget, timed the same way: the wait's late count is
+ * what preemption and timer interrupts alone add on this machine.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+#include "trace.h"
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXLINE 1024		/* max string size */
+#define DEFAULT_BUDGET 1000 /* nanoseconds of compaction per free (-b) */
+
+/******************************
+ * The key compound data types
+ *****************************/
+
+/* The result of replaying a trace */
+typedef struct
+{
+	double secs; /* time of the run */
+	size_t peak; /* peak heap bytes */
+	double avg;	 /* heap bytes averaged over the ops */
+	int passes;	 /* compaction passes that reached the end of the heap */
+	double worst; /* longest single mm_compact call */
+	int late;	 /* mm_compact calls that took over twice the budget */
+	int spin_late; /* the same for a busy wait of one budget */
+} compactstats_t;
+
+/********************
+ * Global variables
+ *******************/
+static char msg[MAXLINE]; /* for whenever we need to compose an error message */
+
+/* Directory where default tracefiles are found */
+static char tracedir[MAXLINE] = TRACEDIR;
+
+/* The same traces mdriver runs by default */
+static char *default_tracefiles[] = {
+	DEFAULT_TRACEFILES, NULL};
+
+/* Current handle of each id in the handle replay */
+static mm_handle_t *handles;
+
+/*********************
+ * Function prototypes
+ *********************/
+static void replay_mm(trace_t *trace, compactstats_t *stats);
+static void replay_handles(trace_t *trace, long budget,
+						   compactstats_t *stats);
+static void fill(char *p, int size, int index);
+static void check(char *p, int size, int index, char *replay);
+static void mm_reset(void);
+static int spin_late(long budget, double *spent);
+static void usage(void);
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+	int i, c;
+	char **tracefiles = NULL;	  /* null-terminated array of trace file names */
+	int num_tracefiles = 0;		  /* the number of traces in that array */
+	long budget = DEFAULT_BUDGET; /* compaction budget per free */
+	trace_t *trace;
+	compactstats_t mm_stats, h_stats;
+
+	while ((c = getopt(argc, argv, "f:t:b:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'f': /* Use one specific trace file only (relative to curr dir) */
+			num_tracefiles = 1;
+			if ((tracefiles = realloc(tracefiles, 2 * sizeof(char *))) == NULL)
+				unix_error("ERROR: realloc failed in main");
+			strcpy(tracedir, "./");
+			tracefiles[0] = strdup(optarg);
+			tracefiles[1] = NULL;
+			break;
+		case 't': /* Directory where the traces are located */
+			if (num_tracefiles == 1) /* ignore if -f already encountered */
+				break;
+			strcpy(tracedir, optarg);
+			if (tracedir[strlen(tracedir) - 1] != '/')
+				strcat(tracedir, "/"); /* path always ends with "/" */
+			break;
+		case 'b': /* Compaction budget per free */
+			budget = atol(optarg);
+			break;
+		case 'h': /* Print this message */
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	if (tracefiles == NULL)
+	{
+		tracefiles = default_tracefiles;
+		num_tracefiles = sizeof(default_tracefiles) / sizeof(char *) - 1;
+		printf("Using default tracefiles in %s\n", tracedir);
+	}
+
+	/* Initialize the simulated memory system in memlib.c */
+	mem_init();
+
+	printf("%-20s%8s%10s%8s%8s%10s%8s%8s%8s%9s%6s%6s\n", "trace", "ops", "mm Kops",
+		   "mm KB", "avg KB", "h Kops", "h KB", "avg KB", "passes", "worst ns",
+		   "late", "spin");
+	for (i = 0; i < num_tracefiles; i++)
+	{
+		trace = read_trace(tracedir, tracefiles[i]);
+		if ((handles = calloc(trace->num_ids, sizeof(mm_handle_t))) == NULL)
+			unix_error("calloc failed in main");
+		replay_mm(trace, &mm_stats);
+		replay_handles(trace, budget, &h_stats);
+		printf("%-20s%8d%10.0f%8.0f%8.0f%10.0f%8.0f%8.0f%8d%9.0f%6d%6d\n", tracefiles[i],
+			   trace->num_ops,
+			   trace->num_ops / 1e3 / mm_stats.secs, mm_stats.peak / 1024.0,
+			   mm_stats.avg / 1024.0,
+			   trace->num_ops / 1e3 / h_stats.secs, h_stats.peak / 1024.0,
+			   h_stats.avg / 1024.0, h_stats.passes, h_stats.worst * 1e9,
+			   h_stats.late, h_stats.spin_late);
+		free(handles);
+		free_trace(trace);
+	}
+
+	mem_deinit();
+	exit(0);
+}
+
+/*
+ * replay_mm - Replay the trace with mm malloc
+ */
+static void replay_mm(trace_t *trace, compactstats_t *stats)
+{
+	traceop_t *op;
+	double start, total = 0;
+	char *p;
+	int i;
+
+	mm_reset();
+	start = now();
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		op = &trace->ops[i];
+		switch (op->type)
+		{
+		case ALLOC:
+			if ((p = mm_malloc(op->size)) == NULL)
+				app_error("mm_malloc failed in replay_mm");
+			fill(p, op->size, op->index);
+			trace->blocks[op->index] = p;
+			trace->block_sizes[op->index] = op->size;
+			break;
+		case REALLOC:
+			if ((p = mm_realloc(trace->blocks[op->index], op->size)) == NULL)
+				app_error("mm_realloc failed in replay_mm");
+			fill(p, op->size, op->index);
+			trace->blocks[op->index] = p;
+			trace->block_sizes[op->index] = op->size;
+			break;
+		case FREE:
+			p = trace->blocks[op->index];
+			check(p, trace->block_sizes[op->index], op->index, "mm");
+			mm_free(p);
+			break;
+		}
+		total += mem_heapsize();
+	}
+	stats->secs = now() - start;
+	stats->peak = mem_heap_peak();
+	stats->avg = total / trace->num_ops;
+	stats->passes = 0;
+	stats->worst = 0;
+	stats->late = 0;
+	stats->spin_late = 0;
+}
+
+/*
+ * replay_handles - Replay the trace with handle blocks, and compact
+ *     for at most budget nanoseconds after every free
+ */
+static void replay_handles(trace_t *trace, long budget,
+						   compactstats_t *stats)
+{
+	traceop_t *op;
+	double start, total = 0, t, spin = 0; /* spin: time of the control waits */
+	mm_handle_t h;
+	char *p;
+	int i;
+
+	mm_reset();
+	stats->passes = 0;
+	stats->worst = 0;
+	stats->late = 0;
+	stats->spin_late = 0;
+	start = now();
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		op = &trace->ops[i];
+		switch (op->type)
+		{
+		case ALLOC:
+			if ((h = mm_halloc(op->size)) == MM_HANDLE_NONE)
+				app_error("mm_halloc failed in replay_handles");
+			fill(mm_hderef(h), op->size, op->index);
+			handles[op->index] = h;
+			trace->block_sizes[op->index] = op->size;
+			break;
+		case REALLOC:
+			h = handles[op->index];
+			if ((p = mm_hrealloc(h, op->size)) == NULL)
+				app_error("mm_hrealloc failed in replay_handles");
+			fill(p, op->size, op->index);
+			trace->block_sizes[op->index] = op->size;
+			break;
+		case FREE:
+			h = handles[op->index];
+			check(mm_hderef(h), trace->block_sizes[op->index], op->index, "handle");
+			mm_hfree(h);
+			t = now();
+			stats->passes += mm_compact(budget);
+			t = now() - t;
+			stats->worst = (t > stats->worst) ? t : stats->worst;
+			if (budget > 0 && t > 2e-9 * budget)
+				stats->late++;
+			stats->spin_late += spin_late(budget, &spin);
+			break;
+		}
+		total += mem_heapsize();
+	}
+	stats->secs = now() - start - spin;
+	stats->peak = mem_heap_peak();
+	stats->avg = total / trace->num_ops;
+}
+
+/*
+ * spin_late - Busy wait for budget nanoseconds, timed like a call to
+ *     mm_compact, and return 1 if it took more than twice the budget.
+ *     The time of the wait is added to *spent.
+ */
+static int spin_late(long budget, double *spent)
+{
+	double t, end;
+
+	if (budget <= 0)
+		return 0;
+	t = now();
+	end = t + 1e-9 * budget;
+	while (now() < end)
+		;
+	t = now() - t;
+	*spent += t;
+	return t > 2e-9 * budget;
+}
+
+/*
+ * fill, check - Write the low byte of index over a block, and make sure
+ *     it is still there
+ */
+static void fill(char *p, int size, int index)
+{
+	memset(p, index & 0xFF, size);
+}
+
+static void check(char *p, int size, int index, char *replay)
+{
+	int j;
+
+	for (j = 0; j < size; j++)
+		if ((unsigned char)p[j] != (index & 0xFF))
+		{
+			snprintf(msg, sizeof(msg),
+					 "Payload of id %d changed in the %s replay", index, replay);
+			app_error(msg);
+		}
+}
+
+/*
+ * mm_reset - Start over with an empty mm heap
+ */
+static void mm_reset(void)
+{
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in mm_reset");
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+	fprintf(stderr, "Usage: compactdriver [-h] [-f <file>] [-t <dir>] "
+					"[-b <ns>]\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-b <ns>   Compaction budget per free in nanoseconds "
+					"(default %d, 0 no limit).\n", DEFAULT_BUDGET);
+	fprintf(stderr, "\t-f <file> Use <file> as the trace file.\n");
+	fprintf(stderr, "\t-h        Print this message.\n");
+	fprintf(stderr, "\t-t <dir>  Directory to find default traces.\n");
+}
@@ -53,20 +53,39 @@
 #define UTIL_WEIGHT .60
 
 /* 
- * Alignment requirement in bytes (either 4 or 8) 
+ * Alignment requirement in bytes (8, 16 or 32). Like MAX_HEAP, it can
+ * be overridden from the command line; mm.c picks it up too:
+ *     make clean; make CFLAGS="-Wall -O2 -g -DALIGNMENT=16"
  */
+#ifndef ALIGNMENT
 #define ALIGNMENT 8  
+#endif
 
 /* 
  * Maximum heap size in bytes 
  */
+#ifndef MAX_HEAP
 #define MAX_HEAP (20*(1<<20))  /* 20 MB */
+#endif
 
 /*****************************************************************************
  * Set exactly one of these USE_xxx constants to "1" to select a timing method
  *****************************************************************************/
-#define USE_FCYC   0   /* cycle counter w/K-best scheme (x86 & Alpha only) */
+#define USE_FCYC   1   /* cycle counter w/K-best scheme (TSC or monotonic clock) */
 #define USE_ITIMER 0   /* interval timer (any Unix box) */
-#define USE_GETTOD 1   /* gettimeofday (any Unix box) */
+#define USE_GETTOD 0   /* gettimeofday (any Unix box) */
+
+/*
+ * With USE_FCYC, traces that finish faster than this are run several
+ * times back to back within each K-best sample, so that timer
+ * resolution and overhead don't dominate the short traces.
+ */
+#define FCYC_MIN_SECS 0.002   /* 2 ms */
+
+/*
+ * If set, the driver pins itself to the CPU it starts on so the
+ * measurements don't migrate between cores mid-run.
+ */
+#define PIN_CPU 1
 
 #endif /* __CONFIG_H */
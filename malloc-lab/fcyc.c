@@ -22,6 +22,8 @@
 #define CLEAR_CACHE 0        /* Clear cache before running test function */
 #define CACHE_BYTES (1<<19)  /* Max cache size in bytes */
 #define CACHE_BLOCK 32       /* Cache block size in bytes */
+#define MIN_CYCLES 0         /* Repeat f until a sample is this long (0 = off) */
+#define MAX_REPS 100000      /* Cap on the number of repetitions per sample */
 
 static int kbest = K;
 static int maxsamples = MAXSAMPLES;
@@ -30,6 +32,7 @@ static int compensate = COMPENSATE;
 static int clear_cache = CLEAR_CACHE;
 static int cache_bytes = CACHE_BYTES;
 static int cache_block = CACHE_BLOCK;
+static double min_cycles = MIN_CYCLES;
 
 static int *cache_buf = NULL;
 
@@ -123,12 +126,35 @@ static void clear()
     sink = x;
 }
 
+/*
+ * choose_reps - Pick how many calls of f make up one sample, so that
+ *     each sample lasts at least min_cycles. Keeps short functions from
+ *     being swamped by the resolution and overhead of the counter.
+ */
+static int choose_reps(test_funct f, void *argp)
+{
+    double cyc, reps;
+
+    if (min_cycles <= 0)
+	return 1;
+    start_counter();
+    f(argp);
+    cyc = get_counter();
+    if (cyc >= min_cycles)
+	return 1;
+    reps = (cyc > 0) ? min_cycles / cyc + 1 : MAX_REPS;
+    return (reps > MAX_REPS) ? MAX_REPS : (int) reps;
+}
+
 /*
  * fcyc - Use K-best scheme to estimate the running time of function f
  */
 double fcyc(test_funct f, void *argp)
 {
     double result;
+    int i, reps;
+
+    reps = choose_reps(f, argp);
     init_sampler();
     if (compensate) {
 	do {
@@ -136,8 +162,9 @@ double fcyc(test_funct f, void *argp)
 	    if (clear_cache)
 		clear();
 	    start_comp_counter();
-	    f(argp);
-	    cyc = get_comp_counter();
+	    for (i = 0; i < reps; i++)
+		f(argp);
+	    cyc = get_comp_counter() / reps;
 	    add_sample(cyc);
 	} while (!has_converged() && samplecount < maxsamples);
     } else {
@@ -146,8 +173,9 @@ double fcyc(test_funct f, void *argp)
 	    if (clear_cache)
 		clear();
 	    start_counter();
-	    f(argp);
-	    cyc = get_counter();
+	    for (i = 0; i < reps; i++)
+		f(argp);
+	    cyc = get_counter() / reps;
 	    add_sample(cyc);
 	} while (!has_converged() && samplecount < maxsamples);
     }
@@ -245,6 +273,16 @@ void set_fcyc_epsilon(double epsilon_arg)
     epsilon = epsilon_arg;
 }
 
+/* 
+ * set_fcyc_min_cycles - Shortest sample, in cycles. Functions that run
+ *     faster than this are called repeatedly within each sample.
+ *     Default = 0 (one call per sample)
+ */
+void set_fcyc_min_cycles(double cycles)
+{
+    min_cycles = cycles;
+}
+
 
 
 
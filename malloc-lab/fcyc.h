@@ -63,6 +63,13 @@ void set_fcyc_maxsamples(int maxsamples_arg);
  */
 void set_fcyc_epsilon(double epsilon_arg);
 
+/* 
+ * set_fcyc_min_cycles - Shortest sample, in cycles. Functions that run
+ *     faster than this are called repeatedly within each sample.
+ *     Default = 0 (one call per sample)
+ */
+void set_fcyc_min_cycles(double cycles);
+
 
 
 
@@ -1,7 +1,9 @@
 /****************************
  * High-level timing wrappers
  ****************************/
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <sched.h>
 #include "fsecs.h"
 #include "fcyc.h"
 #include "clock.h"
@@ -12,6 +14,23 @@ static double Mhz;  /* estimated CPU clock frequency */
 
 extern int verbose; /* -v option in mdriver.c */
 
+/*
+ * pin_cpu - bind the calling process to one CPU (the current one if
+ *     cpu < 0). Returns the CPU, or -1 if the binding failed.
+ */
+int pin_cpu(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0 && (cpu = sched_getcpu()) < 0)
+	return -1;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) < 0)
+	return -1;
+    return cpu;
+}
+
 /*
  * init_fsecs - initialize the timing package
  */
@@ -19,6 +38,14 @@ void init_fsecs(void)
 {
     Mhz = 0; /* keep gcc -Wall happy */
 
+#if PIN_CPU
+    {
+	int cpu = pin_cpu(-1);
+	if (verbose && cpu >= 0)
+	    printf("Pinned to CPU %d.\n", cpu);
+    }
+#endif
+
 #if USE_FCYC
     if (verbose)
 	printf("Measuring performance with a cycle counter.\n");
@@ -26,10 +53,11 @@ void init_fsecs(void)
     /* set key parameters for the fcyc package */
     set_fcyc_maxsamples(20); 
     set_fcyc_clear_cache(1);
-    set_fcyc_compensate(1);
+    set_fcyc_compensate(0);
     set_fcyc_epsilon(0.01);
     set_fcyc_k(3);
     Mhz = mhz(verbose > 0);
+    set_fcyc_min_cycles(FCYC_MIN_SECS * Mhz * 1e6);
 #elif USE_ITIMER
     if (verbose)
 	printf("Measuring performance with the interval timer.\n");
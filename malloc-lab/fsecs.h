@@ -1,4 +1,5 @@
 typedef void (*fsecs_test_funct)(void *);
 
+int pin_cpu(int cpu);
 void init_fsecs(void);
 double fsecs(fsecs_test_funct f, void *argp);
@@ -0,0 +1,345 @@
+/*
+ * heapdriver.c - Check independent heaps (mm_heap_*) next to the default heap
+ *
+ * Replays each trace twice at the same time, one request of each in
+ * turn: once on the default heap with mm_malloc/mm_realloc/mm_free,
+ * and once spread over -n heaps from mm_heap_create, id i going to
+ * heap i % n through mm_heap_malloc/mm_heap_realloc/mm_heap_free.
+ * Halfway through the trace, heap 0 is destroyed with its blocks
+ * still live and a fresh one is created in its place; the requests on
+ * the dropped blocks carry on in the new heap (a realloc of a dropped
+ * block is a realloc of NULL).
+ *
+ * Every block is filled with a byte of its id (the complement on the
+ * independent heaps) and checked before it is freed or realloc'ed and
+ * at the end, so a heap call that touched the wrong heap, or a
+ * destroy that took default blocks with it, shows up as an error. We
+ * also check that default blocks lie in the default memlib region and
+ * the other heaps' blocks don't, i.e. that every mm_heap_* call gives
+ * the default region back when it returns.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+#include "trace.h"
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXLINE 1024	  /* max string size */
+#define MAXHEAPS 64		  /* max independent heaps (-n) */
+#define DEFAULT_HEAPS 4	  /* independent heaps (-n) */
+#define HEAP_MAX (1 << 26) /* region size of each independent heap */
+
+/********************
+ * Global variables
+ *******************/
+static char msg[MAXLINE]; /* for whenever we need to compose an error message */
+
+/* Directory where default tracefiles are found */
+static char tracedir[MAXLINE] = TRACEDIR;
+
+/* The same traces mdriver runs by default */
+static char *default_tracefiles[] = {
+	DEFAULT_TRACEFILES, NULL};
+
+/* The independent heaps, and the block of each id in them */
+static mm_heap_t *heaps[MAXHEAPS];
+static char **hblocks;
+static size_t *hsizes;
+
+/*********************
+ * Function prototypes
+ *********************/
+static int replay(trace_t *trace, int nheaps);
+static void replay_default(trace_t *trace, traceop_t *op);
+static void replay_heap(trace_t *trace, traceop_t *op, int nheaps);
+static void recreate_heap(trace_t *trace, int k, int nheaps);
+static void fill(char *p, size_t size, int byte);
+static void check(char *p, size_t size, int byte, int index, char *heap);
+static int in_default(char *p);
+static void mm_reset(void);
+static void usage(void);
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+	int i, c;
+	char **tracefiles = NULL;	  /* null-terminated array of trace file names */
+	int num_tracefiles = 0;		  /* the number of traces in that array */
+	int nheaps = DEFAULT_HEAPS;	  /* independent heaps */
+	trace_t *trace;
+	int dropped;
+
+	while ((c = getopt(argc, argv, "f:t:n:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'f': /* Use one specific trace file only (relative to curr dir) */
+			num_tracefiles = 1;
+			if ((tracefiles = realloc(tracefiles, 2 * sizeof(char *))) == NULL)
+				unix_error("ERROR: realloc failed in main");
+			strcpy(tracedir, "./");
+			tracefiles[0] = strdup(optarg);
+			tracefiles[1] = NULL;
+			break;
+		case 't': /* Directory where the traces are located */
+			if (num_tracefiles == 1) /* ignore if -f already encountered */
+				break;
+			strcpy(tracedir, optarg);
+			if (tracedir[strlen(tracedir) - 1] != '/')
+				strcat(tracedir, "/"); /* path always ends with "/" */
+			break;
+		case 'n': /* Number of independent heaps */
+			nheaps = atoi(optarg);
+			if (nheaps < 1 || nheaps > MAXHEAPS)
+				app_error("-n must be between 1 and 64");
+			break;
+		case 'h': /* Print this message */
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	if (tracefiles == NULL)
+	{
+		tracefiles = default_tracefiles;
+		num_tracefiles = sizeof(default_tracefiles) / sizeof(char *) - 1;
+		printf("Using default tracefiles in %s\n", tracedir);
+	}
+
+	/* Initialize the simulated memory system in memlib.c */
+	mem_init();
+
+	printf("%-20s%8s%7s%9s%8s\n", "trace", "ops", "heaps", "dropped",
+		   "result");
+	for (i = 0; i < num_tracefiles; i++)
+	{
+		trace = read_trace(tracedir, tracefiles[i]);
+		if ((hblocks = calloc(trace->num_ids, sizeof(char *))) == NULL ||
+			(hsizes = calloc(trace->num_ids, sizeof(size_t))) == NULL)
+			unix_error("calloc failed in main");
+		dropped = replay(trace, nheaps);
+		printf("%-20s%8d%7d%9d%8s\n", tracefiles[i], trace->num_ops, nheaps,
+			   dropped, "ok");
+		free(hblocks);
+		free(hsizes);
+		free_trace(trace);
+	}
+
+	mem_deinit();
+	exit(0);
+}
+
+/*
+ * replay - Replay the trace on the default heap and on nheaps heaps
+ *     in turn, and return how many live blocks the mid-trace destroy
+ *     dropped
+ */
+static int replay(trace_t *trace, int nheaps)
+{
+	char *lo;
+	int i, k, dropped = 0;
+
+	mm_reset();
+	lo = mem_heap_lo();
+	for (k = 0; k < nheaps; k++)
+		if ((heaps[k] = mm_heap_create(HEAP_MAX)) == NULL)
+			app_error("mm_heap_create failed in replay");
+	if (mem_heap_lo() != lo)
+		app_error("mm_heap_create left another memlib region in use");
+
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		if (i == trace->num_ops / 2)
+		{
+			for (k = 0; k < trace->num_ids; k += nheaps)
+				dropped += (hblocks[k] != NULL);
+			recreate_heap(trace, 0, nheaps);
+		}
+		replay_default(trace, &trace->ops[i]);
+		replay_heap(trace, &trace->ops[i], nheaps);
+	}
+
+	/* Whatever an unbalanced trace left live must still be intact */
+	for (i = 0; i < trace->num_ids; i++)
+	{
+		if (trace->blocks[i] != NULL)
+		{
+			check(trace->blocks[i], trace->block_sizes[i], i, i, "default");
+			mm_free(trace->blocks[i]);
+			trace->blocks[i] = NULL;
+		}
+		if (hblocks[i] != NULL)
+			check(hblocks[i], hsizes[i], ~i, i, "independent");
+	}
+	for (k = 0; k < nheaps; k++)
+		mm_heap_destroy(heaps[k]);
+	if (mem_heap_lo() != lo)
+		app_error("mm_heap_destroy left another memlib region in use");
+	return dropped;
+}
+
+/*
+ * replay_default - Do one request on the default heap
+ */
+static void replay_default(trace_t *trace, traceop_t *op)
+{
+	char **bp = &trace->blocks[op->index];
+	size_t *size = &trace->block_sizes[op->index];
+	char *p;
+
+	switch (op->type)
+	{
+	case ALLOC:
+		if ((p = mm_malloc(op->size)) == NULL)
+			app_error("mm_malloc failed in replay_default");
+		break;
+	case REALLOC:
+		check(*bp, *size, op->index, op->index, "default");
+		if ((p = mm_realloc(*bp, op->size)) == NULL)
+			app_error("mm_realloc failed in replay_default");
+		break;
+	case FREE:
+	default:
+		check(*bp, *size, op->index, op->index, "default");
+		mm_free(*bp);
+		*bp = NULL;
+		return;
+	}
+	if (op->size > 0 && !in_default(p))
+	{
+		snprintf(msg, sizeof(msg),
+				 "Default block of id %d is outside the default heap", op->index);
+		app_error(msg);
+	}
+	*bp = p;
+	*size = op->size;
+	fill(p, *size, op->index);
+}
+
+/*
+ * replay_heap - Do one request on the independent heap of its id
+ */
+static void replay_heap(trace_t *trace, traceop_t *op, int nheaps)
+{
+	mm_heap_t *h = heaps[op->index % nheaps];
+	char **bp = &hblocks[op->index];
+	size_t *size = &hsizes[op->index];
+	char *p;
+
+	switch (op->type)
+	{
+	case ALLOC:
+		if ((p = mm_heap_malloc(h, op->size)) == NULL)
+			app_error("mm_heap_malloc failed in replay_heap");
+		break;
+	case REALLOC: /* of NULL if the block was dropped */
+		check(*bp, *size, ~op->index, op->index, "independent");
+		if ((p = mm_heap_realloc(h, *bp, op->size)) == NULL)
+			app_error("mm_heap_realloc failed in replay_heap");
+		break;
+	case FREE:
+	default:
+		if (*bp != NULL) /* not dropped */
+		{
+			check(*bp, *size, ~op->index, op->index, "independent");
+			mm_heap_free(h, *bp);
+		}
+		*bp = NULL;
+		return;
+	}
+	if (op->size > 0 && in_default(p))
+	{
+		snprintf(msg, sizeof(msg),
+				 "Block of id %d is in the default heap", op->index);
+		app_error(msg);
+	}
+	*bp = p;
+	*size = op->size;
+	fill(p, *size, ~op->index);
+}
+
+/*
+ * recreate_heap - Destroy heap k with its live blocks, and put a new
+ *     heap in its place
+ */
+static void recreate_heap(trace_t *trace, int k, int nheaps)
+{
+	int i;
+
+	mm_heap_destroy(heaps[k]);
+	for (i = k; i < trace->num_ids; i += nheaps)
+	{
+		hblocks[i] = NULL;
+		hsizes[i] = 0;
+	}
+	if ((heaps[k] = mm_heap_create(HEAP_MAX)) == NULL)
+		app_error("mm_heap_create failed in recreate_heap");
+}
+
+/*
+ * fill, check - Write the low byte of byte over a block, and make sure
+ *     it is still there
+ */
+static void fill(char *p, size_t size, int byte)
+{
+	memset(p, byte & 0xFF, size);
+}
+
+static void check(char *p, size_t size, int byte, int index, char *heap)
+{
+	size_t j;
+
+	for (j = 0; j < size; j++)
+		if ((unsigned char)p[j] != (byte & 0xFF))
+		{
+			snprintf(msg, sizeof(msg),
+					 "Payload of id %d changed on the %s heap", index, heap);
+			app_error(msg);
+		}
+}
+
+/*
+ * in_default - Is p within the default memlib region?
+ */
+static int in_default(char *p)
+{
+	return p >= (char *)mem_heap_lo() && p <= (char *)mem_heap_hi();
+}
+
+/*
+ * mm_reset - Start over with an empty default heap
+ */
+static void mm_reset(void)
+{
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in mm_reset");
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+	fprintf(stderr, "Usage: heapdriver [-h] [-f <file>] [-t <dir>] "
+					"[-n <heaps>]\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
+	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-n <heaps> Independent heaps (default %d).\n",
+			DEFAULT_HEAPS);
+	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+}
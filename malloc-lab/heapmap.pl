@@ -0,0 +1,144 @@
+#!/usr/bin/perl
+#
+# heapmap.pl - render heap snapshots written by "mdriver --snapshot" as SVG
+#
+# usage: heapmap.pl [-w <width>] [-t <tracenum>] <snapshot file> > map.svg
+#
+# For each trace, the top panel is a heap map: one row per snapshot, time
+# running downward, with the heap address on the x axis. Each pixel is
+# shaded by the fraction of its bytes that are in allocated blocks, so
+# fragmentation shows up as light holes between dark bands. The bottom
+# panel plots heap size, live payload bytes and the largest free block
+# against the op number. Convert to PNG with e.g. rsvg-convert if needed.
+#
+use strict;
+use Getopt::Std;
+
+my %opts;
+getopts('w:t:', \%opts) && @ARGV == 1
+    or die "usage: $0 [-w <width>] [-t <tracenum>] <snapshot file>\n";
+my $width = $opts{w} || 800;
+my $rowh = 3;       # pixels per snapshot row
+my $charth = 200;   # height of the time-series chart
+my $margin = 50;
+
+# Read the snapshots, grouped by trace
+my (@traces, $cur);
+open my $in, '<', $ARGV[0] or die "Cannot open $ARGV[0]: $!\n";
+while (<$in>) {
+    s/\r?\n$//;
+    if (/^T (\d+) (.*)$/) {
+        $cur = { num => $1, name => $2, snaps => [] };
+        push @traces, $cur if !defined $opts{t} || $opts{t} == $1;
+    } elsif (/^S (\d+) (\d+) (\d+) (\d+)$/) {
+        die "$ARGV[0]:$.: snapshot before trace header\n" unless $cur;
+        push @{$cur->{snaps}},
+            { op => $1, heap => $2, live => $3, largest => $4 };
+    } elsif (/^B (\d+)(.*)$/) {
+        my @blocks;
+        my $off = $1;
+        foreach my $b (split ' ', $2) {
+            $b =~ /^(\d+)([af])$/ or die "$ARGV[0]:$.: bad block '$b'\n";
+            push @blocks, [$off, $1, $2 eq 'a'];
+            $off += $1;
+        }
+        $cur->{snaps}[-1]{blocks} = \@blocks;
+    }
+}
+close $in;
+die "No snapshots found\n" unless grep { @{$_->{snaps}} } @traces;
+
+# Fraction of each pixel column covered by allocated blocks
+sub shade_row {
+    my ($blocks, $bytes_per_px) = @_;
+    my @fill;
+    foreach my $b (@$blocks) {
+        my ($lo, $size, $alloc) = @$b;
+        next unless $alloc;
+        my $hi = $lo + $size;
+        for (my $px = int($lo / $bytes_per_px); $px * $bytes_per_px < $hi; $px++) {
+            my $plo = $px * $bytes_per_px;
+            my $phi = $plo + $bytes_per_px;
+            my $ov = ($hi < $phi ? $hi : $phi) - ($lo > $plo ? $lo : $plo);
+            $fill[$px] += $ov / $bytes_per_px if $ov > 0;
+        }
+    }
+    return \@fill;
+}
+
+my @panels;
+my $y = 0;
+foreach my $t (@traces) {
+    my @snaps = @{$t->{snaps}};
+    next unless @snaps;
+    my ($maxheap, $maxop) = (1, 1);
+    foreach my $s (@snaps) {
+        $maxheap = $s->{heap} if $s->{heap} > $maxheap;
+        $maxop = $s->{op} if $s->{op} > $maxop;
+    }
+    my $bpp = $maxheap / $width;
+    my $svg = sprintf qq(<text x="%d" y="%d" font-size="14">trace %d: %s (heap %d bytes, %d ops)</text>\n),
+        $margin, $y + 20, $t->{num}, $t->{name}, $maxheap, $maxop;
+    $y += 30;
+
+    # Heap map: unused heap is white, free blocks light, allocated dark
+    my $maph = $rowh * @snaps;
+    $svg .= sprintf qq(<rect x="%d" y="%d" width="%d" height="%d" fill="white" stroke="black"/>\n),
+        $margin, $y, $width, $maph;
+    foreach my $i (0 .. $#snaps) {
+        my $s = $snaps[$i];
+        my $ry = $y + $i * $rowh;
+        my $used = int($s->{heap} / $bpp + 0.5);
+        $svg .= sprintf qq(<rect x="%d" y="%d" width="%d" height="%d" fill="rgb(230,230,250)"/>\n),
+            $margin, $ry, $used, $rowh;
+        my $fill = shade_row($s->{blocks} || [], $bpp);
+        # Merge runs of equally shaded pixels into one rect
+        my $px = 0;
+        while ($px <= $#$fill) {
+            my $f = $fill->[$px] || 0;
+            $f = 1 if $f > 1;
+            my $c = int(230 - 200 * $f);
+            my $run = 1;
+            while ($px + $run <= $#$fill) {
+                my $g = $fill->[$px + $run] || 0;
+                $g = 1 if $g > 1;
+                last if int(230 - 200 * $g) != $c;
+                $run++;
+            }
+            $svg .= sprintf qq(<rect x="%d" y="%d" width="%d" height="%d" fill="rgb(%d,%d,%d)"/>\n),
+                $margin + $px, $ry, $run, $rowh, $c, $c, $c + 20 if $f > 0;
+            $px += $run;
+        }
+    }
+    $svg .= sprintf qq(<text x="%d" y="%d" font-size="10" text-anchor="end">op %d</text>\n),
+        $margin - 4, $y + 10, $snaps[0]{op};
+    $svg .= sprintf qq(<text x="%d" y="%d" font-size="10" text-anchor="end">op %d</text>\n),
+        $margin - 4, $y + $maph, $snaps[-1]{op};
+    $y += $maph + 20;
+
+    # Time series of heap size, live bytes and the largest free block
+    $svg .= sprintf qq(<rect x="%d" y="%d" width="%d" height="%d" fill="none" stroke="black"/>\n),
+        $margin, $y, $width, $charth;
+    my @series = ([heap => 'black'], [live => 'blue'], [largest => 'red']);
+    foreach my $ser (@series) {
+        my ($key, $color) = @$ser;
+        my $pts = join ' ', map {
+            sprintf '%.1f,%.1f', $margin + $_->{op} / $maxop * $width,
+                $y + $charth - $_->{$key} / $maxheap * $charth
+        } @snaps;
+        $svg .= qq(<polyline fill="none" stroke="$color" points="$pts"/>\n);
+    }
+    my $lx = $margin + $width + 10;
+    foreach my $i (0 .. $#series) {
+        $svg .= sprintf qq(<text x="%d" y="%d" font-size="11" fill="%s">%s</text>\n),
+            $lx, $y + 15 + 15 * $i, $series[$i][1],
+            ('heap size', 'live bytes', 'largest free')[$i];
+    }
+    $y += $charth + 30;
+    push @panels, $svg;
+}
+
+printf qq(<svg xmlns="http://www.w3.org/2000/svg" width="%d" height="%d">\n),
+    $width + 2 * $margin + 80, $y;
+print @panels;
+print "</svg>\n";
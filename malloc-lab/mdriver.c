@@ -16,13 +16,22 @@
 #include <assert.h>
 #include <float.h>
 #include <time.h>
+#include <math.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 extern char *optarg; // Added declaration for optarg
 
 #include "mm.h"
 #include "memlib.h"
 #include "fsecs.h"
+#include "clock.h"
 #include "config.h"
+#include "stats.h"
+#include "report.h"
+#include "perfctr.h"
+#include "trace.h"
 
 /**********************
  * Constants and macros
@@ -32,10 +41,18 @@ extern char *optarg; // Added declaration for optarg
 #define MAXLINE 1024	   /* max string size */
 #define HDRLINES 4		   /* number of header lines in a trace file */
 #define LINENUM(i) (i + 5) /* cnvt trace request nums to linenums (origin 1) */
+#define PERF_MIN_OPS 100000 /* replay short traces up to this many ops for -p */
+#define SNAP_EVERY 1000	  /* default ops between heap snapshots */
+#define LAT_RUNS 5		  /* replays per trace for -L; each op keeps its fastest */
+#define COMPARE_NOISE 20  /* default --noise, in percent */
 
 /* Returns true if p is ALIGNMENT-byte aligned */
 #define IS_ALIGNED(p) ((((uintptr_t)(p)) % ALIGNMENT) == 0)
 
+/* Calls mm_malloc for an alloc request, or mm_malloc_hint if it has a hint */
+#define MM_MALLOC(op) \
+	((op)->hint ? mm_malloc_hint((op)->size, (op)->hint) : mm_malloc((op)->size))
+
 /******************************
  * The key compound data types
  *****************************/
@@ -48,31 +65,6 @@ typedef struct range_t
 	struct range_t *next; /* next list element */
 } range_t;
 
-/* Characterizes a single trace operation (allocator request) */
-typedef struct
-{
-	enum
-	{
-		ALLOC,
-		FREE,
-		REALLOC
-	} type;	   /* type of request */
-	int index; /* index for free() to use later */
-	int size;  /* byte size of alloc/realloc request */
-} traceop_t;
-
-/* Holds the information for one trace file*/
-typedef struct
-{
-	int sugg_heapsize;	 /* suggested heap size (unused) */
-	int num_ids;		 /* number of alloc/realloc ids */
-	int num_ops;		 /* number of distinct requests */
-	int weight;			 /* weight for this trace (unused) */
-	traceop_t *ops;		 /* array of requests */
-	char **blocks;		 /* array of ptrs returned by malloc/realloc... */
-	size_t *block_sizes; /* ... and a corresponding array of payload sizes */
-} trace_t;
-
 /*
  * Holds the params to the xxx_speed functions, which are timed by fcyc.
  * This struct is necessary because fcyc accepts only a pointer array
@@ -84,19 +76,24 @@ typedef struct
 	range_t *ranges;
 } speed_t;
 
-/* Summarizes the important stats for some malloc function on some trace */
+/* Running totals while walking the heap for a snapshot */
 typedef struct
 {
-	/* defined for both libc malloc and student malloc package (mm.c) */
-	double ops;	 /* number of ops (malloc/free/realloc) in the trace */
-	int valid;	 /* was the trace processed correctly by the allocator? */
-	double secs; /* number of secs needed to run the trace */
-
-	/* defined only for the student malloc package */
-	double util; /* space utilization for this trace (always 0 for libc) */
+	size_t largest; /* largest free block so far */
+	char *lo;		/* first byte of the heap */
+} snapwalk_t;
 
-	/* Note: secs and util are only defined if valid is true */
-} stats_t;
+/*
+ * The message a worker process (-j) sends back to the driver for each
+ * trace it has evaluated
+ */
+typedef struct
+{
+	int tracenum; /* index of the trace in tracefiles */
+	int libc;	  /* stats are for libc malloc rather than mm malloc */
+	int errors;	  /* number of mm errors found on this trace */
+	stats_t stats;
+} result_t;
 
 /********************
  * Global variables
@@ -108,10 +105,33 @@ char msg[MAXLINE];	   /* for whenever we need to compose an error message */
 /* Directory where default tracefiles are found */
 static char tracedir[MAXLINE] = TRACEDIR;
 
+/* Heap snapshots taken during the utilization pass (--snapshot) */
+static FILE *snapfp = NULL;
+static int snap_every = SNAP_EVERY;
+
+/* Bound on the cycles of any mm_malloc or mm_free (-L), 0 if unchecked */
+static double lat_bound = 0;
+
+/* Names of the MEM_PAGES_* kinds, as given to --hugepages */
+static char *page_names[] = {"off", "thp", "hugetlb"};
+
 /* The filenames of the default tracefiles */
 static char *default_tracefiles[] = {
 	DEFAULT_TRACEFILES, NULL};
 
+/* Long options for machine-readable output and baseline comparison */
+static struct option long_options[] = {
+	{"json", required_argument, NULL, 'J'},
+	{"csv", required_argument, NULL, 'C'},
+	{"compare", required_argument, NULL, 'B'},
+	{"runs", required_argument, NULL, 'R'},
+	{"noise", required_argument, NULL, 'N'},
+	{"procs", required_argument, NULL, 'P'},
+	{"snapshot", required_argument, NULL, 'S'},
+	{"snapshot-every", required_argument, NULL, 'E'},
+	{"hugepages", required_argument, NULL, 'H'},
+	{NULL, 0, NULL, 0}};
+
 /*********************
  * Function prototypes
  *********************/
@@ -122,10 +142,6 @@ static int add_range(range_t **ranges, char *lo, int size,
 static void remove_range(range_t **ranges, char *lo);
 static void clear_ranges(range_t **ranges);
 
-/* These functions read, allocate, and free storage for traces */
-static trace_t *read_trace(char *tracedir, char *filename);
-static void free_trace(trace_t *trace);
-
 /* Routines for evaluating the correctness and speed of libc malloc */
 static int eval_libc_valid(trace_t *trace, int tracenum);
 static void eval_libc_speed(void *ptr);
@@ -133,15 +149,38 @@ static void eval_libc_speed(void *ptr);
 /* Routines for evaluating correctnes, space utilization, and speed
    of the student's malloc package in mm.c */
 static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges);
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges);
+static void eval_mm_util(trace_t *trace, int tracenum, range_t **ranges,
+						 stats_t *stats);
 static void eval_mm_speed(void *ptr);
+static void time_op_types(trace_t *trace, stats_t *stats, int libc);
+static void eval_mm_latency(trace_t *trace, stats_t *stats);
+
+/* Routines that run all the evaluations for a single trace */
+static void eval_libc_trace(char *tracefile, int tracenum, stats_t *stats,
+							int runs, int perf);
+static void eval_mm_trace(char *tracefile, int tracenum, stats_t *stats,
+						  range_t **ranges, int runs, int perf);
+static void run_workers(int nworkers, char **tracefiles, int n,
+						stats_t *libc_stats, stats_t *mm_stats,
+						int runs, int perf);
+static void run_procs(int nprocs, int nworkers, char **tracefiles, int n,
+					  stats_t *libc_stats, stats_t *mm_stats,
+					  int runs, int perf);
 
 /* Various helper routines */
-static void printresults(int n, stats_t *stats);
+static void count_ops(trace_t *trace, stats_t *stats);
+static void time_trace(fsecs_test_funct f, speed_t *params, stats_t *stats,
+					   int runs);
+static void count_events(perf_test_funct f, speed_t *params, stats_t *stats);
+static void write_snapshot(int opnum, int live);
+static void write_report(char *path, int csv, char **tracefiles, int n,
+						 stats_t *mm_stats, stats_t *libc_stats,
+						 double perfindex);
+static void printresults(int n, stats_t *stats, int space);
+static void printperf(int n, stats_t *stats);
+static int printlatency(int n, stats_t *stats);
 static void usage(void);
-static void unix_error(char *msg);
 static void malloc_error(int tracenum, int opnum, char *msg);
-static void app_error(char *msg);
 
 /**************
  * Main routine
@@ -152,15 +191,24 @@ int main(int argc, char **argv)
 	int c;
 	char **tracefiles = NULL;	/* null-terminated array of trace file names */
 	int num_tracefiles = 0;		/* the number of traces in that array */
-	trace_t *trace = NULL;		/* stores a single trace file in memory */
 	range_t *ranges = NULL;		/* keeps track of block extents for one trace */
 	stats_t *libc_stats = NULL; /* libc stats for each trace */
 	stats_t *mm_stats = NULL;	/* mm (i.e. student) stats for each trace */
-	speed_t speed_params;		/* input parameters to the xx_speed routines */
 
 	int team_check = 1; /* If set, check team structure (reset by -a) */
 	int run_libc = 0;	/* If set, run libc malloc (set by -l) */
 	int autograder = 0; /* If set, emit summary info for autograder (-g) */
+	int runs = 1;		/* Number of timing runs per trace (--runs) */
+	int perf = 0;		/* If set, count hardware events (-p) */
+	int nworkers = 1;	/* Number of worker processes (-j) */
+	int nprocs = 1;		/* Separate processes to time each trace in (--procs) */
+	char *json_file = NULL; /* If set, write JSON results here (--json) */
+	char *csv_file = NULL;	/* If set, write CSV results here (--csv) */
+	char *base_file = NULL; /* If set, compare against this (--compare) */
+	double noise = COMPARE_NOISE / 100.0; /* Spread between driver runs (--noise) */
+	int regressions = 0;	/* Regressions found against the baseline */
+	int slow = 0;			/* Traces over the latency bound (-L) */
+	int pages = MEM_PAGES_SMALL; /* Pages under the heap (--hugepages) */
 
 	/* temporaries used to compute the performance index */
 	double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
@@ -169,7 +217,8 @@ int main(int argc, char **argv)
 	/*
 	 * Read and interpret the command line arguments
 	 */
-	while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF)
+	while ((c = getopt_long(argc, argv, "f:t:j:L:hvVgalp", long_options,
+							NULL)) != EOF)
 	{
 		printf("getopt returned: %d\n", c); // 디버깅용 출력 추가
 
@@ -193,18 +242,66 @@ int main(int argc, char **argv)
 			if (tracedir[strlen(tracedir) - 1] != '/')
 				strcat(tracedir, "/"); /* path always ends with "/" */
 			break;
+		case 'j': /* Evaluate the traces in parallel worker processes */
+			if ((nworkers = atoi(optarg)) < 1)
+				app_error("-j must be at least 1");
+			break;
+		case 'L': /* Check every malloc/free against a cycle bound */
+			if ((lat_bound = atof(optarg)) <= 0)
+				app_error("-L must be a positive number of cycles");
+			break;
 		case 'a': /* Don't check team structure */
 			team_check = 0;
 			break;
 		case 'l': /* Run libc malloc */
 			run_libc = 1;
 			break;
+		case 'p': /* Count hardware events with perf_event_open */
+			perf = 1;
+			break;
 		case 'v': /* Print per-trace performance breakdown */
 			verbose = 1;
 			break;
 		case 'V': /* Be more verbose than -v */
 			verbose = 2;
 			break;
+		case 'J': /* Write per-trace results as JSON */
+			json_file = optarg;
+			break;
+		case 'C': /* Write per-trace results as CSV */
+			csv_file = optarg;
+			break;
+		case 'B': /* Flag regressions against a baseline JSON file */
+			base_file = optarg;
+			break;
+		case 'R': /* Repeat the timing runs to estimate their spread */
+			if ((runs = atoi(optarg)) < 1)
+				app_error("--runs must be at least 1");
+			break;
+		case 'N': /* Throughput spread between separate driver runs */
+			if ((noise = atof(optarg) / 100.0) < 0)
+				app_error("--noise must not be negative");
+			break;
+		case 'P': /* Time each trace in separate processes */
+			if ((nprocs = atoi(optarg)) < 1)
+				app_error("--procs must be at least 1");
+			break;
+		case 'S': /* Record heap snapshots during the utilization pass */
+			if ((snapfp = fopen(optarg, "w")) == NULL)
+				unix_error("Could not open snapshot file");
+			break;
+		case 'E': /* Ops between heap snapshots */
+			if ((snap_every = atoi(optarg)) < 1)
+				app_error("--snapshot-every must be at least 1");
+			break;
+		case 'H': /* Back the simulated heap with huge pages */
+			for (pages = MEM_PAGES_HUGETLB; pages > MEM_PAGES_SMALL; pages--)
+				if (!strcmp(optarg, page_names[pages]))
+					break;
+			if (strcmp(optarg, page_names[pages]))
+				app_error("--hugepages must be off, thp or hugetlb");
+			mem_set_pages(pages);
+			break;
 		case 'h': /* Print this message */
 			usage();
 			exit(0);
@@ -256,92 +353,108 @@ int main(int argc, char **argv)
 		printf("Using default tracefiles in %s\n", tracedir);
 	}
 
+	/* All workers would write to the same snapshot file */
+	if (snapfp && (nworkers > 1 || nprocs > 1))
+		app_error("--snapshot can't be combined with -j or --procs");
+
 	/* Initialize the timing package */
 	init_fsecs();
 
-	/*
-	 * Optionally run and evaluate the libc malloc package
-	 */
+	/* Optionally open the hardware event counters */
+	if (perf && perf_init(1) == 0)
+		perf = 0;
+
+	/* Allocate libc stats array, with one stats_t struct per tracefile */
 	if (run_libc)
 	{
-		if (verbose > 1)
-			printf("\nTesting libc malloc\n");
-
-		/* Allocate libc stats array, with one stats_t struct per tracefile */
 		libc_stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
 		if (libc_stats == NULL)
 			unix_error("libc_stats calloc in main failed");
+	}
 
-		/* Evaluate the libc malloc package using the K-best scheme */
-		for (i = 0; i < num_tracefiles; i++)
+	/* Allocate the mm stats array, with one stats_t struct per tracefile */
+	mm_stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
+	if (mm_stats == NULL)
+		unix_error("mm_stats calloc in main failed");
+
+	/*
+	 * With -j or --procs, evaluate both packages on all traces in
+	 * worker processes
+	 */
+	if (nprocs > 1)
+		run_procs(nprocs, nworkers, tracefiles, num_tracefiles,
+				  libc_stats, mm_stats, runs, perf);
+	else if (nworkers > 1)
+		run_workers(nworkers, tracefiles, num_tracefiles,
+					libc_stats, mm_stats, runs, perf);
+	else
+		nworkers = 0; /* evaluate them here */
+
+	/*
+	 * Optionally run and evaluate the libc malloc package
+	 */
+	if (run_libc)
+	{
+		if (nworkers == 0)
 		{
-			trace = read_trace(tracedir, tracefiles[i]);
-			libc_stats[i].ops = trace->num_ops;
 			if (verbose > 1)
-				printf("Checking libc malloc for correctness, ");
-			libc_stats[i].valid = eval_libc_valid(trace, i);
-			if (libc_stats[i].valid)
-			{
-				speed_params.trace = trace;
-				if (verbose > 1)
-					printf("and performance.\n");
-				libc_stats[i].secs = fsecs(eval_libc_speed, &speed_params);
-			}
-			free_trace(trace);
+				printf("\nTesting libc malloc\n");
+
+			/* Evaluate the libc malloc package using the K-best scheme */
+			for (i = 0; i < num_tracefiles; i++)
+				eval_libc_trace(tracefiles[i], i, &libc_stats[i], runs, perf);
 		}
 
 		/* Display the libc results in a compact table */
 		if (verbose)
 		{
 			printf("\nResults for libc malloc:\n");
-			printresults(num_tracefiles, libc_stats);
+			printresults(num_tracefiles, libc_stats, 0);
+			if (perf)
+				printperf(num_tracefiles, libc_stats);
 		}
 	}
 
 	/*
 	 * Always run and evaluate the student's mm package
 	 */
-	if (verbose > 1)
-		printf("\nTesting mm malloc\n");
-
-	/* Allocate the mm stats array, with one stats_t struct per tracefile */
-	mm_stats = (stats_t *)calloc(num_tracefiles, sizeof(stats_t));
-	if (mm_stats == NULL)
-		unix_error("mm_stats calloc in main failed");
-
-	/* Initialize the simulated memory system in memlib.c */
-	mem_init();
-
-	/* Evaluate student's mm malloc package using the K-best scheme */
-	for (i = 0; i < num_tracefiles; i++)
+	if (nworkers == 0)
 	{
-		trace = read_trace(tracedir, tracefiles[i]);
-		mm_stats[i].ops = trace->num_ops;
 		if (verbose > 1)
-			printf("Checking mm_malloc for correctness, ");
-		mm_stats[i].valid = eval_mm_valid(trace, i, &ranges);
-		if (mm_stats[i].valid)
-		{
-			if (verbose > 1)
-				printf("efficiency, ");
-			mm_stats[i].util = eval_mm_util(trace, i, &ranges);
-			speed_params.trace = trace;
-			speed_params.ranges = ranges;
-			if (verbose > 1)
-				printf("and performance.\n");
-			mm_stats[i].secs = fsecs(eval_mm_speed, &speed_params);
-		}
-		free_trace(trace);
+			printf("\nTesting mm malloc\n");
+
+		/* Initialize the simulated memory system in memlib.c */
+		mem_init();
+		if (pages != MEM_PAGES_SMALL)
+			printf("Heap pages: %s (asked for %s)\n",
+				   page_names[mem_pages()], page_names[pages]);
+
+		/* Evaluate student's mm malloc package using the K-best scheme */
+		for (i = 0; i < num_tracefiles; i++)
+			eval_mm_trace(tracefiles[i], i, &mm_stats[i], &ranges, runs, perf);
 	}
 
 	/* Display the mm results in a compact table */
 	if (verbose)
 	{
 		printf("\nResults for mm malloc:\n");
-		printresults(num_tracefiles, mm_stats);
+		printresults(num_tracefiles, mm_stats, 1);
 		printf("\n");
 	}
 
+	/* Display the per-op latencies and check them against the bound */
+	if (lat_bound > 0)
+		slow = printlatency(num_tracefiles, mm_stats);
+
+	/* Display the per-op hardware event counts */
+	if (perf)
+	{
+		printf("Hardware events per op for mm malloc:\n");
+		printperf(num_tracefiles, mm_stats);
+		printf("\n");
+		perf_deinit();
+	}
+
 	/*
 	 * Accumulate the aggregate statistics for the student's mm package
 	 */
@@ -395,7 +508,31 @@ int main(int argc, char **argv)
 		printf("perfidx:%.0f\n", perfindex);
 	}
 
-	exit(0);
+	/*
+	 * Optionally write machine-readable results and check them
+	 * against a baseline from an earlier run
+	 */
+	if (json_file)
+		write_report(json_file, 0, tracefiles, num_tracefiles,
+					 mm_stats, libc_stats, perfindex);
+	if (csv_file)
+		write_report(csv_file, 1, tracefiles, num_tracefiles,
+					 mm_stats, libc_stats, perfindex);
+	if (snapfp)
+		fclose(snapfp);
+	if (base_file)
+	{
+		regressions = report_compare(base_file, tracefiles, num_tracefiles,
+									 mm_stats, libc_stats, noise);
+		if (regressions < 0)
+		{
+			snprintf(msg, sizeof(msg), "Could not read baseline %s", base_file);
+			app_error(msg);
+		}
+		printf("%d regressions against %s\n", regressions, base_file);
+	}
+
+	exit(regressions > 0 || slow > 0);
 }
 
 /*****************************************************************
@@ -502,110 +639,6 @@ static void clear_ranges(range_t **ranges)
 	*ranges = NULL;
 }
 
-/**********************************************
- * The following routines manipulate tracefiles
- *********************************************/
-
-/*
- * read_trace - read a trace file and store it in memory
- */
-static trace_t *read_trace(char *tracedir, char *filename)
-{
-	FILE *tracefile;
-	trace_t *trace;
-	char type[MAXLINE];
-	char path[MAXLINE];
-	unsigned index, size;
-	unsigned max_index = 0;
-	unsigned op_index;
-
-	if (verbose > 1)
-		printf("Reading tracefile: %s\n", filename);
-
-	/* Allocate the trace record */
-	if ((trace = (trace_t *)malloc(sizeof(trace_t))) == NULL)
-		unix_error("malloc 1 failed in read_trance");
-
-	/* Read the trace file header */
-	strcpy(path, tracedir);
-	strcat(path, filename);
-	if ((tracefile = fopen(path, "r")) == NULL)
-	{
-		snprintf(msg, sizeof(msg), "Could not open %s in read_trace", path);
-		unix_error(msg);
-	}
-	fscanf(tracefile, "%d", &(trace->sugg_heapsize)); /* not used */
-	fscanf(tracefile, "%d", &(trace->num_ids));
-	fscanf(tracefile, "%d", &(trace->num_ops));
-	fscanf(tracefile, "%d", &(trace->weight)); /* not used */
-
-	/* We'll store each request line in the trace in this array */
-	if ((trace->ops =
-			 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
-		unix_error("malloc 2 failed in read_trace");
-
-	/* We'll keep an array of pointers to the allocated blocks here... */
-	if ((trace->blocks =
-			 (char **)malloc(trace->num_ids * sizeof(char *))) == NULL)
-		unix_error("malloc 3 failed in read_trace");
-
-	/* ... along with the corresponding byte sizes of each block */
-	if ((trace->block_sizes =
-			 (size_t *)malloc(trace->num_ids * sizeof(size_t))) == NULL)
-		unix_error("malloc 4 failed in read_trace");
-
-	/* read every request line in the trace file */
-	index = 0;
-	op_index = 0;
-	while (fscanf(tracefile, "%s", type) != EOF)
-	{
-		switch (type[0])
-		{
-		case 'a':
-			fscanf(tracefile, "%u %u", &index, &size);
-			trace->ops[op_index].type = ALLOC;
-			trace->ops[op_index].index = index;
-			trace->ops[op_index].size = size;
-			max_index = (index > max_index) ? index : max_index;
-			break;
-		case 'r':
-			fscanf(tracefile, "%u %u", &index, &size);
-			trace->ops[op_index].type = REALLOC;
-			trace->ops[op_index].index = index;
-			trace->ops[op_index].size = size;
-			max_index = (index > max_index) ? index : max_index;
-			break;
-		case 'f':
-			fscanf(tracefile, "%ud", &index);
-			trace->ops[op_index].type = FREE;
-			trace->ops[op_index].index = index;
-			break;
-		default:
-			printf("Bogus type character (%c) in tracefile %s\n",
-				   type[0], path);
-			exit(1);
-		}
-		op_index++;
-	}
-	fclose(tracefile);
-	assert(max_index == trace->num_ids - 1);
-	assert(trace->num_ops == op_index);
-
-	return trace;
-}
-
-/*
- * free_trace - Free the trace record and the three arrays it points
- *              to, all of which were allocated in read_trace().
- */
-void free_trace(trace_t *trace)
-{
-	free(trace->ops); /* free the three arrays... */
-	free(trace->blocks);
-	free(trace->block_sizes);
-	free(trace); /* and the trace record itself... */
-}
-
 /**********************************************************************
  * The following functions evaluate the correctness, space utilization,
  * and throughput of the libc and mm malloc packages.
@@ -647,7 +680,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 		case ALLOC: /* mm_malloc */
 
 			/* Call the student's malloc */
-			if ((p = mm_malloc(size)) == NULL)
+			if ((p = MM_MALLOC(&trace->ops[i])) == NULL)
 			{
 				malloc_error(tracenum, i, "mm_malloc failed.");
 				return 0;
@@ -700,7 +733,7 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 				oldsize = size;
 			for (j = 0; j < oldsize; j++)
 			{
-				if (newp[j] != (index & 0xFF))
+				if ((unsigned char)newp[j] != (index & 0xFF))
 				{
 					malloc_error(tracenum, i, "mm_realloc did not preserve the "
 											  "data from old block");
@@ -737,28 +770,51 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
  *   an optimal allocator, i.e., no gaps and no internal fragmentation.
  *   Utilization is the ratio hwm/heapsize, where heapsize is the
  *   size of the heap in bytes after running the student's malloc
- *   package on the trace. Note that our implementation of mem_sbrk()
- *   doesn't allow the students to decrement the brk pointer, so brk
- *   is always the high water mark of the heap.
+ *   package on the trace. mem_sbrk() lets the brk pointer move down,
+ *   so heapsize is the peak brk reported by mem_heap_peak().
+ *
+ *   Peak utilization can't tell an allocator that reuses its heap from
+ *   one that grows early and never shrinks, so this also records the
+ *   time-averaged utilization (live bytes over heap bytes, averaged
+ *   over all ops), the peak live bytes, the number of mem_sbrk calls,
+ *   and the heap size left by mm_trim() just before the final run of
+ *   frees, while the blocks that the trace frees last are still live.
+ *   (After the last free every allocator trims down to nothing.)
  *
+ *   With --snapshot, the heap is also walked every snap_every ops.
  */
-static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
+static void eval_mm_util(trace_t *trace, int tracenum, range_t **ranges,
+						 stats_t *stats)
 {
 	int i;
 	int index;
 	int size, newsize, oldsize;
 	int max_total_size = 0;
 	int total_size = 0;
+	int last_frees; /* first op of the final run of frees */
+	long trim_sbrks = 0; /* mem_sbrk calls made by that mm_trim */
+	double util_sum = 0;
 	char *p;
 	char *newp, *oldp;
 
+	for (last_frees = trace->num_ops; last_frees > 0; last_frees--)
+		if (trace->ops[last_frees - 1].type != FREE)
+			break;
+
 	/* initialize the heap and the mm malloc package */
 	mem_reset_brk();
 	if (mm_init() < 0)
 		app_error("mm_init failed in eval_mm_util");
+	stats->trimmed = 0;
 
 	for (i = 0; i < trace->num_ops; i++)
 	{
+		if (i == last_frees)
+		{
+			trim_sbrks = (mm_trim() > 0);
+			stats->trimmed = mem_heapsize();
+		}
+
 		switch (trace->ops[i].type)
 		{
 
@@ -766,7 +822,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 			index = trace->ops[i].index;
 			size = trace->ops[i].size;
 
-			if ((p = mm_malloc(size)) == NULL)
+			if ((p = MM_MALLOC(&trace->ops[i])) == NULL)
 				app_error("mm_malloc failed in eval_mm_util");
 
 			/* Remember region and size */
@@ -818,9 +874,172 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 		default:
 			app_error("Nonexistent request type in eval_mm_util");
 		}
+
+		if (mem_heapsize() > 0)
+			util_sum += (double)total_size / (double)mem_heapsize();
+
+		if (snapfp && ((i + 1) % snap_every == 0 || i + 1 == trace->num_ops))
+			write_snapshot(i + 1, total_size);
+	}
+
+	stats->util = (double)max_total_size / (double)mem_heap_peak();
+	stats->util_avg = (trace->num_ops > 0) ? util_sum / trace->num_ops : 0;
+	stats->live = max_total_size;
+	stats->heap = mem_heap_peak();
+	stats->sbrks = mem_sbrk_calls() - trim_sbrks;
+	if (last_frees == trace->num_ops)
+	{
+		mm_trim();
+		stats->trimmed = mem_heapsize();
+	}
+}
+
+/*
+ * cmp_double - qsort comparison for doubles
+ */
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * eval_mm_latency - Time every mm_malloc and mm_free of the trace
+ *    with the cycle counter. The trace is replayed LAT_RUNS times and
+ *    each op keeps its fastest time, which filters out interrupts and
+ *    the page faults of the first replay; the percentiles of those
+ *    are the cost of the allocator's own code path. The slowest time
+ *    of any op in any replay is kept too (lat_worst), since that is
+ *    what a caller with a deadline sees, and -L checks it. Reallocs
+ *    are replayed but not timed, since their copy is linear in the
+ *    block size.
+ */
+static void eval_mm_latency(trace_t *trace, stats_t *stats)
+{
+	int i, r, n, index;
+	double c, *lat, *sorted;
+	char *p;
+
+	stats->lat_worst = 0;
+	lat = (double *)malloc(trace->num_ops * sizeof(double));
+	sorted = (double *)malloc(trace->num_ops * sizeof(double));
+	if (lat == NULL || sorted == NULL)
+		unix_error("malloc failed in eval_mm_latency");
+
+	for (r = 0; r < LAT_RUNS; r++)
+	{
+		mem_reset_brk();
+		if (mm_init() < 0)
+			app_error("mm_init failed in eval_mm_latency");
+
+		for (i = 0; i < trace->num_ops; i++)
+		{
+			index = trace->ops[i].index;
+			switch (trace->ops[i].type)
+			{
+			case ALLOC:
+				start_counter();
+				p = MM_MALLOC(&trace->ops[i]);
+				c = get_counter();
+				if (p == NULL)
+					app_error("mm_malloc error in eval_mm_latency");
+				trace->blocks[index] = p;
+				break;
+
+			case REALLOC:
+				if ((p = mm_realloc(trace->blocks[index],
+									trace->ops[i].size)) == NULL)
+					app_error("mm_realloc error in eval_mm_latency");
+				trace->blocks[index] = p;
+				c = -1;
+				break;
+
+			case FREE:
+				p = trace->blocks[index];
+				start_counter();
+				mm_free(p);
+				c = get_counter();
+				break;
+
+			default:
+				app_error("Nonexistent request type in eval_mm_latency");
+			}
+			if (r == 0 || c < lat[i])
+				lat[i] = c;
+			if (c > stats->lat_worst)
+				stats->lat_worst = c;
+		}
 	}
 
-	return ((double)max_total_size / (double)mem_heapsize());
+	for (i = 0, n = 0; i < trace->num_ops; i++)
+		if (lat[i] >= 0)
+			sorted[n++] = lat[i];
+	qsort(sorted, n, sizeof(double), cmp_double);
+	stats->lat_ops = n;
+	if (n > 0)
+	{
+		stats->lat_p50 = sorted[n / 2];
+		stats->lat_p99 = sorted[(int)(0.99 * (n - 1))];
+		stats->lat_max = sorted[n - 1];
+	}
+	free(lat);
+	free(sorted);
+}
+
+/*
+ * time_op_types - Replay the trace once more, timing every request
+ *    with the cycle counter, and record the mean cycles of a malloc,
+ *    free and realloc of mm (or of libc, if libc is set). The cycles
+ *    include the counter's own overhead.
+ */
+static void time_op_types(trace_t *trace, stats_t *stats, int libc)
+{
+	int i, index, size;
+	double sum[3] = {0, 0, 0}; /* indexed by the request type */
+	char *p;
+
+	if (!libc)
+	{
+		mem_reset_brk();
+		if (mm_init() < 0)
+			app_error("mm_init failed in time_op_types");
+	}
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		index = trace->ops[i].index;
+		size = trace->ops[i].size;
+		start_counter();
+		switch (trace->ops[i].type)
+		{
+		case ALLOC:
+			p = libc ? malloc(size) : MM_MALLOC(&trace->ops[i]);
+			break;
+
+		case REALLOC:
+			p = libc ? realloc(trace->blocks[index], size)
+					 : mm_realloc(trace->blocks[index], size);
+			break;
+
+		case FREE:
+			p = trace->blocks[index];
+			if (libc)
+				free(p);
+			else
+				mm_free(p);
+			break;
+
+		default:
+			app_error("Nonexistent request type in time_op_types");
+		}
+		sum[trace->ops[i].type] += get_counter();
+		if (p == NULL)
+			app_error("malloc/realloc failed in time_op_types");
+		trace->blocks[index] = p;
+	}
+	stats->cyc_malloc = stats->allocs ? sum[ALLOC] / stats->allocs : 0;
+	stats->cyc_free = stats->frees ? sum[FREE] / stats->frees : 0;
+	stats->cyc_realloc = stats->reallocs ? sum[REALLOC] / stats->reallocs : 0;
 }
 
 /*
@@ -829,7 +1048,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
  */
 static void eval_mm_speed(void *ptr)
 {
-	int i, index, size, newsize;
+	int i, index, newsize;
 	char *p, *newp, *oldp, *block;
 	trace_t *trace = ((speed_t *)ptr)->trace;
 
@@ -845,8 +1064,7 @@ static void eval_mm_speed(void *ptr)
 
 		case ALLOC: /* mm_malloc */
 			index = trace->ops[i].index;
-			size = trace->ops[i].size;
-			if ((p = mm_malloc(size)) == NULL)
+			if ((p = MM_MALLOC(&trace->ops[i])) == NULL)
 				app_error("mm_malloc error in eval_mm_speed");
 			trace->blocks[index] = p;
 			break;
@@ -962,87 +1180,580 @@ static void eval_libc_speed(void *ptr)
 	}
 }
 
+/*****************************************************************
+ * The following routines run every evaluation for one trace, either
+ * in the driver itself or in worker processes (-j)
+ ****************************************************************/
+
+/*
+ * eval_libc_trace - Check libc malloc on a trace and time it
+ */
+static void eval_libc_trace(char *tracefile, int tracenum, stats_t *stats,
+							int runs, int perf)
+{
+	trace_t *trace;
+	speed_t speed_params;
+
+	if (verbose > 1)
+		printf("Reading tracefile: %s\n", tracefile);
+	trace = read_trace(tracedir, tracefile);
+	stats->ops = trace->num_ops;
+	count_ops(trace, stats);
+	if (verbose > 1)
+		printf("Checking libc malloc for correctness, ");
+	stats->valid = eval_libc_valid(trace, tracenum);
+	if (stats->valid)
+	{
+		speed_params.trace = trace;
+		if (verbose > 1)
+			printf("and performance.\n");
+		time_trace(eval_libc_speed, &speed_params, stats, runs);
+		time_op_types(trace, stats, 1);
+		if (perf)
+			count_events(eval_libc_speed, &speed_params, stats);
+	}
+	free_trace(trace);
+}
+
+/*
+ * eval_mm_trace - Check the mm malloc package on a trace, measure its
+ *     space utilization and time it
+ */
+static void eval_mm_trace(char *tracefile, int tracenum, stats_t *stats,
+						  range_t **ranges, int runs, int perf)
+{
+	trace_t *trace;
+	speed_t speed_params;
+
+	if (verbose > 1)
+		printf("Reading tracefile: %s\n", tracefile);
+	trace = read_trace(tracedir, tracefile);
+	stats->ops = trace->num_ops;
+	count_ops(trace, stats);
+	if (verbose > 1)
+		printf("Checking mm_malloc for correctness, ");
+	stats->valid = eval_mm_valid(trace, tracenum, ranges);
+	if (stats->valid)
+	{
+		if (verbose > 1)
+			printf("efficiency, ");
+		if (snapfp)
+			fprintf(snapfp, "T %d %s\n", tracenum, tracefile);
+		eval_mm_util(trace, tracenum, ranges, stats);
+		speed_params.trace = trace;
+		speed_params.ranges = *ranges;
+		if (verbose > 1)
+			printf("and performance.\n");
+		time_trace(eval_mm_speed, &speed_params, stats, runs);
+		time_op_types(trace, stats, 0);
+		if (perf)
+			count_events(eval_mm_speed, &speed_params, stats);
+		if (lat_bound > 0)
+			eval_mm_latency(trace, stats);
+	}
+	free_trace(trace);
+}
+
+/*
+ * run_workers - Evaluate the traces in nworkers forked processes.
+ *     Each worker has its own simulated heap (mem_init), so the memlib
+ *     state of one trace never collides with another. Workers pull
+ *     the next trace number from a counter shared with the others and
+ *     send one result_t per evaluated trace back over a pipe. The
+ *     utilization and validity of each trace don't depend on which
+ *     worker ran it, so they match a serial run exactly; throughput is
+ *     measured while the workers compete for caches and memory.
+ */
+static void run_workers(int nworkers, char **tracefiles, int n,
+						stats_t *libc_stats, stats_t *mm_stats,
+						int runs, int perf)
+{
+	int *next;		 /* next trace number, shared by the workers */
+	int (*fds)[2];	 /* one pipe per worker */
+	pid_t *pids;
+	range_t *ranges = NULL;
+	result_t res;
+	int w, i, status;
+	int done = 0;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	next = mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (next == MAP_FAILED)
+		unix_error("mmap failed in run_workers");
+	*next = 0;
+	if ((fds = malloc(nworkers * sizeof(*fds))) == NULL ||
+		(pids = malloc(nworkers * sizeof(pid_t))) == NULL)
+		unix_error("malloc failed in run_workers");
+
+	/* Don't let the workers inherit (and repeat) our buffered output */
+	fflush(stdout);
+
+	for (w = 0; w < nworkers; w++)
+	{
+		if (pipe(fds[w]) < 0)
+			unix_error("pipe failed in run_workers");
+		if ((pids[w] = fork()) < 0)
+			unix_error("fork failed in run_workers");
+
+		if (pids[w] == 0)
+		{ /* Worker */
+			close(fds[w][0]);
+#if PIN_CPU
+			if (ncpus > 0)
+				pin_cpu(w % ncpus);
+#endif
+			/* Counters opened by the driver count the driver, not us */
+			if (perf)
+			{
+				perf_deinit();
+				perf = perf_init(0) > 0;
+			}
+			mem_init();
+			while ((i = __sync_fetch_and_add(next, 1)) < n)
+			{
+				if (libc_stats)
+				{
+					memset(&res, 0, sizeof(res));
+					res.tracenum = i;
+					res.libc = 1;
+					eval_libc_trace(tracefiles[i], i, &res.stats, runs, perf);
+					if (write(fds[w][1], &res, sizeof(res)) != sizeof(res))
+						unix_error("write failed in run_workers");
+				}
+				memset(&res, 0, sizeof(res));
+				res.tracenum = i;
+				res.errors = errors;
+				eval_mm_trace(tracefiles[i], i, &res.stats, &ranges, runs, perf);
+				res.errors = errors - res.errors;
+				if (write(fds[w][1], &res, sizeof(res)) != sizeof(res))
+					unix_error("write failed in run_workers");
+			}
+			fflush(stdout);
+			_exit(0);
+		}
+		close(fds[w][1]);
+	}
+
+	/* Collect the results of every worker */
+	for (w = 0; w < nworkers; w++)
+	{
+		while (read(fds[w][0], &res, sizeof(res)) == sizeof(res))
+		{
+			if (res.libc)
+				libc_stats[res.tracenum] = res.stats;
+			else
+			{
+				mm_stats[res.tracenum] = res.stats;
+				errors += res.errors;
+				done++;
+			}
+		}
+		close(fds[w][0]);
+		if (waitpid(pids[w], &status, 0) < 0)
+			unix_error("waitpid failed in run_workers");
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			printf("ERROR: worker %d %s %d\n", w,
+				   WIFSIGNALED(status) ? "killed by signal" : "exited with",
+				   WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+			errors++;
+		}
+	}
+
+	/* A trace whose worker died before reporting it counts as invalid */
+	if (done < n)
+	{
+		printf("ERROR: %d traces were not evaluated\n", n - done);
+		errors += n - done;
+	}
+
+	free(fds);
+	free(pids);
+	munmap(next, sizeof(int));
+}
+
+/*
+ * tally_round, finish_rounds - Sum the running time and throughput of
+ *     one trace over the rounds of run_procs, and turn the sums into
+ *     the mean time and the spread of the throughput between rounds
+ */
+static void tally_round(double *sum, stats_t *stats)
+{
+	double kops;
+
+	if (!stats->valid || stats->secs <= 0)
+		return;
+	kops = (stats->ops / 1e3) / stats->secs;
+	sum[0] += stats->secs;
+	sum[1] += kops;
+	sum[2] += kops * kops;
+}
+
+static void finish_rounds(double *sum, stats_t *stats, int nprocs)
+{
+	if (!stats->valid)
+		return;
+	stats->secs = sum[0] / nprocs;
+	stats->procs = nprocs;
+	stats->kops_sd = 0;
+	if (sum[2] > sum[1] * sum[1] / nprocs)
+		stats->kops_sd = sqrt((sum[2] - sum[1] * sum[1] / nprocs) / (nprocs - 1));
+}
+
+/*
+ * run_procs - Evaluate the traces in nprocs rounds of worker processes,
+ *     one round after another (nworkers of them at a time, -j). The
+ *     runs of one process share its CPU, its memory layout and the load
+ *     of the machine at the time, so they agree more closely than
+ *     separate runs of the driver do; the rounds measure that spread
+ *     between processes. Each trace gets the mean running time over the
+ *     rounds, and kops_sd becomes the spread of the rounds' throughput.
+ *     The rest of its stats come from the first round.
+ */
+static void run_procs(int nprocs, int nworkers, char **tracefiles, int n,
+					  stats_t *libc_stats, stats_t *mm_stats,
+					  int runs, int perf)
+{
+	stats_t *mm_round, *libc_round = NULL;
+	double *sum; /* per trace: secs, Kops and Kops^2 for mm, then libc */
+	int p, i, before, more = 0;
+
+	if ((mm_round = malloc(n * sizeof(stats_t))) == NULL ||
+		(libc_stats && (libc_round = malloc(n * sizeof(stats_t))) == NULL) ||
+		(sum = calloc(6 * n, sizeof(double))) == NULL)
+		unix_error("malloc failed in run_procs");
+
+	for (p = 0; p < nprocs; p++)
+	{
+		/* Errors repeat from round to round; count the worst round's */
+		before = errors;
+		run_workers(nworkers, tracefiles, n, libc_round,
+					mm_round, runs, perf);
+		more = (errors - before > more) ? errors - before : more;
+		errors = before;
+		if (p == 0)
+		{
+			memcpy(mm_stats, mm_round, n * sizeof(stats_t));
+			if (libc_stats)
+				memcpy(libc_stats, libc_round, n * sizeof(stats_t));
+		}
+		for (i = 0; i < n; i++)
+		{
+			tally_round(&sum[6 * i], &mm_round[i]);
+			if (libc_stats)
+				tally_round(&sum[6 * i + 3], &libc_round[i]);
+		}
+	}
+	errors += more;
+
+	for (i = 0; i < n; i++)
+	{
+		finish_rounds(&sum[6 * i], &mm_stats[i], nprocs);
+		if (libc_stats)
+			finish_rounds(&sum[6 * i + 3], &libc_stats[i], nprocs);
+	}
+	free(mm_round);
+	free(libc_round);
+	free(sum);
+}
+
 /*************************************
  * Some miscellaneous helper routines
  ************************************/
 
 /*
- * printresults - prints a performance summary for some malloc package
+ * count_ops - tally the requests of a trace by type
  */
-static void printresults(int n, stats_t *stats)
+static void count_ops(trace_t *trace, stats_t *stats)
+{
+	int i;
+
+	stats->allocs = stats->frees = stats->reallocs = 0;
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		switch (trace->ops[i].type)
+		{
+		case ALLOC:
+			stats->allocs++;
+			break;
+		case FREE:
+			stats->frees++;
+			break;
+		case REALLOC:
+			stats->reallocs++;
+			break;
+		}
+	}
+}
+
+/*
+ * time_trace - time f on a trace runs times. Records the mean running
+ *     time and the spread of the throughput across the runs.
+ */
+static void time_trace(fsecs_test_funct f, speed_t *params, stats_t *stats,
+					   int runs)
+{
+	int r;
+	double secs, kops;
+	double sum = 0, ksum = 0, ksumsq = 0;
+
+	for (r = 0; r < runs; r++)
+	{
+		secs = fsecs(f, params);
+		kops = (stats->ops / 1e3) / secs;
+		sum += secs;
+		ksum += kops;
+		ksumsq += kops * kops;
+	}
+	stats->secs = sum / runs;
+	stats->runs = runs;
+	stats->procs = 1;
+	stats->kops_sd = 0;
+	if (runs > 1 && ksumsq > ksum * ksum / runs)
+		stats->kops_sd = sqrt((ksumsq - ksum * ksum / runs) / (runs - 1));
+}
+
+/*
+ * count_events - count hardware events per op while replaying a trace.
+ *     Short traces are replayed several times to get stable counts.
+ */
+static void count_events(perf_test_funct f, speed_t *params, stats_t *stats)
+{
+	int e, reps = PERF_MIN_OPS / stats->ops + 1;
+
+	perf_measure(f, params, reps, stats->perf);
+	for (e = 0; e < PERF_NCOUNTERS; e++)
+		if (stats->perf[e] >= 0)
+			stats->perf[e] /= stats->ops * reps;
+	stats->counted = 1;
+}
+
+/*
+ * snapshot_largest - mm_walk visitor that finds the largest free block
+ */
+static void snapshot_largest(void *bp, size_t size, int alloc, void *arg)
+{
+	snapwalk_t *w = (snapwalk_t *)arg;
+
+	if (!alloc && size > w->largest)
+		w->largest = size;
+}
+
+/*
+ * snapshot_block - mm_walk visitor that writes one block as <size>a or
+ *     <size>f. Blocks are contiguous, so the offsets are implied.
+ */
+static void snapshot_block(void *bp, size_t size, int alloc, void *arg)
+{
+	snapwalk_t *w = (snapwalk_t *)arg;
+
+	if (w->lo)
+	{
+		fprintf(snapfp, " %ld", (long)((char *)bp - w->lo));
+		w->lo = NULL;
+	}
+	fprintf(snapfp, " %lu%c", (unsigned long)size, alloc ? 'a' : 'f');
+}
+
+/*
+ * write_snapshot - append a snapshot of the heap after opnum ops:
+ *     S <opnum> <heap bytes> <live payload bytes> <largest free block>
+ *     B <offset of first block payload> <size><a|f> ...
+ */
+static void write_snapshot(int opnum, int live)
+{
+	snapwalk_t w;
+
+	w.largest = 0;
+	mm_walk(snapshot_largest, &w);
+	fprintf(snapfp, "S %d %lu %d %lu\nB", opnum,
+			(unsigned long)mem_heapsize(), live, (unsigned long)w.largest);
+	w.lo = (char *)mem_heap_lo();
+	mm_walk(snapshot_block, &w);
+	fprintf(snapfp, "\n");
+}
+
+/*
+ * write_report - write the results as JSON or CSV to path
+ */
+static void write_report(char *path, int csv, char **tracefiles, int n,
+						 stats_t *mm_stats, stats_t *libc_stats,
+						 double perfindex)
+{
+	FILE *fp;
+
+	if ((fp = fopen(path, "w")) == NULL)
+	{
+		snprintf(msg, sizeof(msg), "Could not open %s in write_report", path);
+		unix_error(msg);
+	}
+	if (csv)
+		report_csv(fp, tracefiles, n, mm_stats, libc_stats);
+	else
+		report_json(fp, tracefiles, n, mm_stats, libc_stats, perfindex);
+	fclose(fp);
+}
+
+/*
+ * printresults - prints a performance summary for some malloc package.
+ *     If space is set, also prints the time-averaged utilization, the
+ *     peak heap over the peak live bytes, the mem_sbrk calls and the
+ *     heap size after mm_trim before the trace's final frees.
+ */
+static void printresults(int n, stats_t *stats, int space)
 {
 	int i;
 	double secs = 0;
 	double ops = 0;
 	double util = 0;
+	double util_avg = 0;
+	double blowup = 0;
+	double trimmed = 0;
+	long sbrks = 0;
+	double ratio;
 
 	/* Print the individual results for each trace */
-	printf("%5s%7s %5s%8s%10s%6s\n",
+	printf("%5s%7s %5s%8s%10s%6s",
 		   "trace", " valid", "util", "ops", "secs", "Kops");
+	if (space)
+		printf("%7s%7s%7s%9s", "tutil", "heap/", "sbrk", "trim KB");
+	printf("\n");
+	if (space)
+		printf("%49s\n", "live");
 	for (i = 0; i < n; i++)
 	{
 		if (stats[i].valid)
 		{
-			printf("%2d%10s%5.0f%%%8.0f%10.6f%6.0f\n",
+			ratio = stats[i].live ? (double)stats[i].heap / stats[i].live : 0;
+			printf("%2d%10s%5.0f%%%8.0f%10.6f%6.0f",
 				   i,
 				   "yes",
 				   stats[i].util * 100.0,
 				   stats[i].ops,
 				   stats[i].secs,
 				   (stats[i].ops / 1e3) / stats[i].secs);
+			if (space)
+				printf("%6.0f%%%7.2f%7ld%9.0f",
+					   stats[i].util_avg * 100.0,
+					   ratio,
+					   stats[i].sbrks,
+					   stats[i].trimmed / 1024.0);
+			printf("\n");
 			secs += stats[i].secs;
 			ops += stats[i].ops;
 			util += stats[i].util;
+			util_avg += stats[i].util_avg;
+			blowup += ratio;
+			trimmed += stats[i].trimmed;
+			sbrks += stats[i].sbrks;
 		}
 		else
 		{
-			printf("%2d%10s%6s%8s%10s%6s\n",
+			printf("%2d%10s%6s%8s%10s%6s",
 				   i,
 				   "no",
 				   "-",
 				   "-",
 				   "-",
 				   "-");
+			if (space)
+				printf("%7s%7s%7s%9s", "-", "-", "-", "-");
+			printf("\n");
 		}
 	}
 
 	/* Print the aggregate results for the set of traces */
 	if (errors == 0)
 	{
-		printf("%12s%5.0f%%%8.0f%10.6f%6.0f\n",
+		printf("%12s%5.0f%%%8.0f%10.6f%6.0f",
 			   "Total       ",
 			   (util / n) * 100.0,
 			   ops,
 			   secs,
 			   (ops / 1e3) / secs);
+		if (space)
+			printf("%6.0f%%%7.2f%7ld%9.0f",
+				   (util_avg / n) * 100.0,
+				   blowup / n,
+				   sbrks,
+				   trimmed / 1024.0);
+		printf("\n");
 	}
 	else
 	{
-		printf("%12s%6s%8s%10s%6s\n",
+		printf("%12s%6s%8s%10s%6s",
 			   "Total       ",
 			   "-",
 			   "-",
 			   "-",
 			   "-");
+		if (space)
+			printf("%7s%7s%7s%9s", "-", "-", "-", "-");
+		printf("\n");
 	}
 }
 
 /*
- * app_error - Report an arbitrary application error
+ * printperf - prints the per-op hardware event counts for some malloc
+ *     package, as collected by count_events
  */
-void app_error(char *msg)
+static void printperf(int n, stats_t *stats)
 {
-	printf("%s\n", msg);
-	exit(1);
+	int i, e;
+
+	printf("%5s%9s%9s%9s%9s%9s%9s\n",
+		   "trace", "cyc/op", "ins/op", "L1D/op", "LLC/op", "dTLB/op", "brm/op");
+	for (i = 0; i < n; i++)
+	{
+		printf("%2d   ", i);
+		for (e = 0; e < PERF_NCOUNTERS; e++)
+		{
+			if (stats[i].valid && stats[i].counted && stats[i].perf[e] >= 0)
+				printf("%9.2f", stats[i].perf[e]);
+			else
+				printf("%9s", "-");
+		}
+		printf("\n");
+	}
 }
 
 /*
- * unix_error - Report a Unix-style error
+ * printlatency - prints the per-op latency percentiles of mm malloc
+ *     and returns the number of traces where some malloc or free took
+ *     longer than lat_bound cycles in some run
  */
-void unix_error(char *msg)
+static int printlatency(int n, stats_t *stats)
 {
-	printf("%s: %s\n", msg, strerror(errno));
-	exit(1);
+	int i, slow = 0;
+	double worst = 0;
+
+	printf("Per-op latency of mm_malloc/mm_free in cycles (p50-max: fastest of "
+		   "%d runs, worst: any run):\n", LAT_RUNS);
+	printf("%5s%9s%9s%9s%10s%10s\n", "trace", "ops", "p50", "p99", "max",
+		   "worst");
+	for (i = 0; i < n; i++)
+	{
+		if (!stats[i].valid || stats[i].lat_ops == 0)
+		{
+			printf("%2d%12s%9s%9s%10s%10s\n", i, "-", "-", "-", "-", "-");
+			continue;
+		}
+		printf("%2d%12d%9.0f%9.0f%10.0f%10.0f%s\n", i, stats[i].lat_ops,
+			   stats[i].lat_p50, stats[i].lat_p99, stats[i].lat_max,
+			   stats[i].lat_worst,
+			   stats[i].lat_worst > lat_bound ? "  OVER BOUND" : "");
+		if (stats[i].lat_worst > worst)
+			worst = stats[i].lat_worst;
+		if (stats[i].lat_worst > lat_bound)
+			slow++;
+	}
+	if (slow)
+		printf("LATENCY BOUND EXCEEDED: %d traces over %.0f cycles "
+			   "(worst %.0f)\n\n", slow, lat_bound, worst);
+	else
+		printf("All ops within %.0f cycles (worst %.0f)\n\n", lat_bound, worst);
+	return slow;
 }
 
 /*
@@ -1059,14 +1770,37 @@ void malloc_error(int tracenum, int opnum, char *msg)
  */
 static void usage(void)
 {
-	fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+	fprintf(stderr, "Usage: mdriver [-hvValp] [-f <file>] [-t <dir>] [-j <n>] "
+					"[-L <cyc>]\n");
+	fprintf(stderr, "               [--runs <n>] [--json <file>] [--csv <file>] "
+					"[--compare <file>]\n");
+	fprintf(stderr, "               [--procs <n>] [--noise <pct>]\n");
 	fprintf(stderr, "Options\n");
 	fprintf(stderr, "\t-a         Don't check the team structure.\n");
 	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
 	fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
 	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-j <n>     Evaluate the traces in n worker processes.\n");
 	fprintf(stderr, "\t-l         Run libc malloc as well.\n");
+	fprintf(stderr, "\t-L <cyc>   Fail if any malloc/free takes more than "
+					"<cyc> cycles.\n");
+	fprintf(stderr, "\t-p         Count hardware events per op (perf_event_open).\n");
 	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
 	fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
 	fprintf(stderr, "\t-V         Print additional debug info.\n");
+	fprintf(stderr, "\t--runs <n>        Time each trace n times (default 1).\n");
+	fprintf(stderr, "\t--json <file>     Write per-trace results as JSON.\n");
+	fprintf(stderr, "\t--csv <file>      Write per-trace results as CSV.\n");
+	fprintf(stderr, "\t--compare <file>  Flag regressions against a JSON "
+					"baseline.\n");
+	fprintf(stderr, "\t--procs <n>       Time each trace in n separate "
+					"processes.\n");
+	fprintf(stderr, "\t--noise <pct>     Spread between processes to assume "
+					"(default %d).\n", COMPARE_NOISE);
+	fprintf(stderr, "\t--snapshot <file> Write heap snapshots to <file> "
+					"(render with heapmap.pl).\n");
+	fprintf(stderr, "\t--snapshot-every <n>  Ops between snapshots "
+					"(default %d).\n", SNAP_EVERY);
+	fprintf(stderr, "\t--hugepages <kind>  Back the heap with off (default), "
+					"thp or hugetlb pages.\n");
 }
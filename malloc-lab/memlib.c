@@ -2,7 +2,22 @@
  * memlib.c - a module that simulates the memory system.  Needed because it 
  *            allows us to interleave calls from the student's malloc package 
  *            with the system's malloc package in libc.
+ *
+ *            The heap is an anonymous mmap, so that mem_remap can move
+ *            whole pages of it around with mremap. mem_set_pages asks
+ *            for 2 MB pages under it, to cut the dTLB misses of long
+ *            heap walks.
+ *
+ *            mem_set_guard makes the pages above the heap
+ *            inaccessible, so that a write past the end of the heap
+ *            faults instead of landing in unused memory.
+ *
+ *            mem_init sets up the default region. mem_region_create
+ *            makes more, independent ones (one per mm_heap_t), and
+ *            mem_region_use picks the region the other mem_* functions
+ *            work on.
  */
+#define _GNU_SOURCE /* mremap */
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -10,14 +25,152 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 
 #include "memlib.h"
 #include "config.h"
 
+#define HUGE_PAGE (2 * (1 << 20)) /* size of an x86-64 huge page */
+
+/* One simulated heap */
+struct mem_region {
+    char *start_brk;  /* points to first byte of heap */
+    char *brk;        /* points to last byte of heap */
+    char *max_addr;   /* largest legal heap address */ 
+    char *peak_brk;   /* highest brk since the last reset */
+    long nsbrk;       /* mem_sbrk calls since the last reset */
+    long nremap;      /* mem_remap calls that moved pages */
+    char *map;        /* the whole mapping under the heap */
+    size_t map_size;  /* its size in bytes */
+    int pages;        /* MEM_PAGES_* the mapping got */
+    char *guard_addr; /* first PROT_NONE byte above the heap, NULL if off */
+};
+
 /* private variables */
-static char *mem_start_brk;  /* points to first byte of heap */
-static char *mem_brk;        /* points to last byte of heap */
-static char *mem_max_addr;   /* largest legal heap address */ 
+static mem_region_t mem_default;     /* the region set up by mem_init */
+static mem_region_t *mem = &mem_default; /* the region in use */
+static int mem_want_pages = MEM_PAGES_SMALL; /* set by mem_set_pages */
+
+/*
+ * thp_available - true unless transparent huge pages are compiled out
+ *    or turned off with "never"
+ */
+static int thp_available(void)
+{
+    char buf[128];
+    FILE *fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    int ok = 0;
+
+    if (fp != NULL) {
+        ok = fgets(buf, sizeof(buf), fp) != NULL && !strstr(buf, "[never]");
+        fclose(fp);
+    }
+    return ok;
+}
+
+/*
+ * region_map - map max bytes for region r, with the pages asked for by
+ *    mem_set_pages if the system has them. Returns -1 if mmap fails.
+ */
+static int region_map(mem_region_t *r, size_t max)
+{
+    size_t size = (max + HUGE_PAGE - 1) & ~(size_t)(HUGE_PAGE - 1);
+
+    r->pages = MEM_PAGES_SMALL;
+    r->map = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (mem_want_pages == MEM_PAGES_HUGETLB) {
+        r->map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (r->map != MAP_FAILED) {
+            r->map_size = size;
+            r->start_brk = r->map;
+            r->pages = MEM_PAGES_HUGETLB;
+        }
+    }
+#endif
+    if (r->map == MAP_FAILED) {
+        /* one huge page of slack, so the heap can start on a boundary */
+        r->map_size = size + (mem_want_pages != MEM_PAGES_SMALL ? HUGE_PAGE : 0);
+        r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (r->map == MAP_FAILED)
+            return -1;
+        r->start_brk = r->map;
+#ifdef MADV_HUGEPAGE
+        if (mem_want_pages != MEM_PAGES_SMALL && thp_available()) {
+            r->start_brk = (char *)(((uintptr_t)r->map + HUGE_PAGE - 1) &
+                                    ~(uintptr_t)(HUGE_PAGE - 1));
+            if (madvise(r->start_brk, size, MADV_HUGEPAGE) == 0)
+                r->pages = MEM_PAGES_THP;
+        }
+#endif
+    }
+
+    r->max_addr = r->start_brk + max;  /* max legal heap address */
+    r->brk = r->start_brk;             /* heap is empty initially */
+    r->peak_brk = r->start_brk;
+    r->nsbrk = 0;
+    r->nremap = 0;
+    r->guard_addr = NULL;
+    return 0;
+}
+
+/*
+ * guard_page - the unit mem_set_guard protects in: a small page, or a
+ *    huge page if the region got huge pages
+ */
+static size_t guard_page(void)
+{
+    return mem->pages == MEM_PAGES_SMALL ? (size_t)getpagesize() : HUGE_PAGE;
+}
+
+/*
+ * guard_move - put the guard at brk rounded up to a guard page:
+ *    open the pages the heap grew into, or close the pages a shrink
+ *    gave back. Only the tail of the last heap page stays writable
+ *    past the end of the heap.
+ */
+static void guard_move(void)
+{
+    size_t pg = guard_page();
+    char *end = mem->map + mem->map_size;
+    char *to = (char *)(((uintptr_t)mem->brk + pg - 1) & ~(uintptr_t)(pg - 1));
+    int rc = 0;
+
+    if (to > end)
+        to = end;
+    if (to > mem->guard_addr)
+        rc = mprotect(mem->guard_addr, to - mem->guard_addr, PROT_READ | PROT_WRITE);
+    else if (to < mem->guard_addr)
+        rc = mprotect(to, mem->guard_addr - to, PROT_NONE);
+    if (rc < 0) {
+	fprintf(stderr, "mem_sbrk: mprotect error\n");
+	exit(1);
+    }
+    mem->guard_addr = to;
+}
+
+/*
+ * mem_set_pages - choose the pages the next mem_init (or
+ *    mem_region_create) puts under the heap: MEM_PAGES_SMALL,
+ *    MEM_PAGES_THP (transparent huge pages via madvise) or
+ *    MEM_PAGES_HUGETLB (reserved huge pages, falling back to THP if
+ *    none are available)
+ */
+void mem_set_pages(int kind)
+{
+    mem_want_pages = kind;
+}
+
+/*
+ * mem_pages - returns the pages the region in use actually got, which
+ *    is less than what mem_set_pages asked for if the system has none
+ */
+int mem_pages(void)
+{
+    return mem->pages;
+}
 
 /* 
  * mem_init - initialize the memory system model
@@ -25,13 +178,11 @@ static char *mem_max_addr;   /* largest legal heap address */
 void mem_init(void)
 {
     /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
-	fprintf(stderr, "mem_init_vm: malloc error\n");
+    if (region_map(&mem_default, MAX_HEAP) < 0) {
+	fprintf(stderr, "mem_init_vm: mmap error\n");
 	exit(1);
     }
-
-    mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
-    mem_brk = mem_start_brk;                  /* heap is empty initially */
+    mem = &mem_default;
 }
 
 /* 
@@ -39,7 +190,76 @@ void mem_init(void)
  */
 void mem_deinit(void)
 {
-    free(mem_start_brk);
+    munmap(mem_default.map, mem_default.map_size);
+}
+
+/*
+ * mem_region_create - make a new region of at most max bytes, separate
+ *    from the default one. Returns NULL if it can't be mapped.
+ */
+mem_region_t *mem_region_create(size_t max)
+{
+    mem_region_t *r = malloc(sizeof(mem_region_t));
+
+    if (r == NULL)
+        return NULL;
+    if (region_map(r, max) < 0) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+/*
+ * mem_region_destroy - give all of region r back to the system at once
+ */
+void mem_region_destroy(mem_region_t *r)
+{
+    if (mem == r)
+        mem = &mem_default;
+    munmap(r->map, r->map_size);
+    free(r);
+}
+
+/*
+ * mem_region_use - make r (NULL for the default region) the region the
+ *    other mem_* functions work on, and return the one used before
+ */
+mem_region_t *mem_region_use(mem_region_t *r)
+{
+    mem_region_t *old = mem;
+
+    mem = r ? r : &mem_default;
+    return old;
+}
+
+/*
+ * mem_set_guard - with on, make the pages of the region in use above
+ *    the heap PROT_NONE, so that a write past the end of the heap
+ *    faults; with !on, open them again. mem_sbrk and mem_reset_brk
+ *    keep the guard at the page-rounded brk as the heap grows and
+ *    shrinks. Returns -1 if mprotect fails.
+ */
+int mem_set_guard(int on)
+{
+    size_t pg = guard_page();
+    char *end = mem->map + mem->map_size;
+    char *from;
+
+    if (!on) {
+        if (mem->guard_addr != NULL &&
+            mprotect(mem->guard_addr, end - mem->guard_addr, PROT_READ | PROT_WRITE) < 0)
+            return -1;
+        mem->guard_addr = NULL;
+        return 0;
+    }
+    if (mem->guard_addr != NULL)
+        return 0;
+    from = (char *)(((uintptr_t)mem->brk + pg - 1) & ~(uintptr_t)(pg - 1));
+    if (from < end && mprotect(from, end - from, PROT_NONE) < 0)
+        return -1;
+    mem->guard_addr = from;
+    return 0;
 }
 
 /*
@@ -47,33 +267,94 @@ void mem_deinit(void)
  */
 void mem_reset_brk()
 {
-    mem_brk = mem_start_brk;
+    mem->brk = mem->start_brk;
+    mem->peak_brk = mem->start_brk;
+    mem->nsbrk = 0;
+    mem->nremap = 0;
+    if (mem->guard_addr != NULL)
+        guard_move();
 }
 
 /* 
  * mem_sbrk - simple model of the sbrk function. Extends the heap 
- *    by incr bytes and returns the start address of the new area. In
- *    this model, the heap cannot be shrunk.
+ *    by incr bytes and returns the start address of the new area. A
+ *    negative incr gives the top -incr bytes back (see mm_trim); the
+ *    peak size is kept in mem_heap_peak().
  */
 void *mem_sbrk(int incr) 
 {
-    char *old_brk = mem_brk;
+    char *old_brk = mem->brk;
 
-    if ( (incr < 0) || ((mem_brk + incr) > mem_max_addr)) {
+    mem->nsbrk++;
+    if ( (mem->brk + incr < mem->start_brk) || ((mem->brk + incr) > mem->max_addr)) {
 	errno = ENOMEM;
 	fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
 	return (void *)-1;
     }
-    mem_brk += incr;
+    mem->brk += incr;
+    if (mem->brk > mem->peak_brk)
+        mem->peak_brk = mem->brk;
+    if (mem->guard_addr != NULL)
+        guard_move();
     return (void *)old_brk;
 }
 
+/*
+ * mem_remap - copy len bytes from src to dst within the heap. The
+ *    whole pages of src are moved to dst with mremap instead of being
+ *    copied, and only the partial head and tail pages are copied; this
+ *    needs src and dst at the same offset within a page, otherwise
+ *    (or if the range spans no whole page, or mremap fails) all of it
+ *    is copied. Every copy goes through copy, so the allocator's own
+ *    copy routine handles the bytes that can't be moved. The ranges
+ *    must not overlap, and the moved-from pages of src read as zero
+ *    afterwards.
+ */
+void *mem_remap(void *dst, const void *src, size_t len,
+                void (*copy)(void *, const void *, size_t))
+{
+    size_t pg = mem_pagesize();
+    char *d = dst;
+    const char *s = src;
+    size_t head = (pg - ((uintptr_t)s & (pg - 1))) & (pg - 1);
+    size_t body;
+
+    /* reserved huge pages can't be remapped in small-page pieces */
+    if ((((uintptr_t)s - (uintptr_t)d) & (pg - 1)) != 0 || len < head + pg ||
+        mem->pages == MEM_PAGES_HUGETLB) {
+        copy(dst, src, len);
+        return dst;
+    }
+
+    body = (len - head) & ~(pg - 1);
+    copy(d, s, head);
+    copy(d + head + body, s + head + body, len - head - body);
+    if (mremap((void *)(s + head), body, body, MREMAP_MAYMOVE | MREMAP_FIXED,
+               d + head) == MAP_FAILED) {
+        copy(d + head, s + head, body);
+        return dst;
+    }
+
+    /* put fresh pages back in the hole mremap left in the heap */
+    if (mmap((void *)(s + head), body, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+	fprintf(stderr, "mem_remap: mmap error\n");
+	exit(1);
+    }
+#ifdef MADV_HUGEPAGE
+    if (mem->pages == MEM_PAGES_THP)
+        madvise((void *)(s + head), body, MADV_HUGEPAGE);
+#endif
+    mem->nremap++;
+    return dst;
+}
+
 /*
  * mem_heap_lo - return address of the first heap byte
  */
 void *mem_heap_lo()
 {
-    return (void *)mem_start_brk;
+    return (void *)mem->start_brk;
 }
 
 /* 
@@ -81,7 +362,7 @@ void *mem_heap_lo()
  */
 void *mem_heap_hi()
 {
-    return (void *)(mem_brk - 1);
+    return (void *)(mem->brk - 1);
 }
 
 /*
@@ -89,7 +370,34 @@ void *mem_heap_hi()
  */
 size_t mem_heapsize() 
 {
-    return (size_t)(mem_brk - mem_start_brk);
+    return (size_t)(mem->brk - mem->start_brk);
+}
+
+/*
+ * mem_heap_peak() - returns the largest heap size in bytes since the
+ *    last mem_init or mem_reset_brk
+ */
+size_t mem_heap_peak()
+{
+    return (size_t)(mem->peak_brk - mem->start_brk);
+}
+
+/*
+ * mem_sbrk_calls() - returns the number of mem_sbrk calls since the
+ *    last mem_init or mem_reset_brk
+ */
+long mem_sbrk_calls()
+{
+    return mem->nsbrk;
+}
+
+/*
+ * mem_remap_calls() - returns the number of mem_remap calls that moved
+ *    pages since the last mem_init or mem_reset_brk
+ */
+long mem_remap_calls()
+{
+    return mem->nremap;
 }
 
 /*
@@ -1,11 +1,30 @@
 #include <unistd.h>
 
+/* Pages under the simulated heap (mem_set_pages, mem_pages) */
+#define MEM_PAGES_SMALL   0 /* ordinary pages */
+#define MEM_PAGES_THP     1 /* transparent huge pages (madvise) */
+#define MEM_PAGES_HUGETLB 2 /* reserved huge pages (MAP_HUGETLB) */
+
+/* An independent simulated heap (mem_init sets up the default one) */
+typedef struct mem_region mem_region_t;
+
+void mem_set_pages(int kind);
+int mem_pages(void);
 void mem_init(void);               
 void mem_deinit(void);
+mem_region_t *mem_region_create(size_t max);
+void mem_region_destroy(mem_region_t *r);
+mem_region_t *mem_region_use(mem_region_t *r);
+int mem_set_guard(int on);
 void *mem_sbrk(int incr);
+void *mem_remap(void *dst, const void *src, size_t len,
+                void (*copy)(void *, const void *, size_t));
 void mem_reset_brk(void); 
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_heap_peak(void);
+long mem_sbrk_calls(void);
+long mem_remap_calls(void);
 size_t mem_pagesize(void);
 
@@ -3,22 +3,196 @@
 #include <assert.h>
 #include <unistd.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#if MM_HARDEN
+#include <sys/random.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include "mm.h"
 #include "memlib.h"
 
-/** @brief 워드 사이즈 (4바이트) */
-#define WSIZE 4
+/*
+ * 설정 (컴파일 타임)
+ *
+ * 아래 MM_* 값은 모두 -D로 바꿀 수 있고, 전처리기에서 골라지기 때문에
+ * 각 빌드의 malloc/free 경로에는 설정을 확인하는 분기가 남지 않는다.
+ * Makefile의 mdriver-<variant> 타깃이 변형별 설정을 모아둔 곳.
+ *
+ *   MM_HDR_BYTES   헤더/푸터 크기 (4 또는 8)
+ *   MM_CHUNKSIZE   힙 확장 기본 크기
+ *   MM_GROWTH      힙 확장 정책 (MM_GROW_CHUNK / MM_GROW_EXACT / MM_GROW_ADAPTIVE)
+ *   MM_GROW_CAP    적응형 확장 단위의 상한
+ *   MM_GROW_WINDOW 확장 사이 malloc이 이보다 적으면 확장 단위를 두 배로
+ *   MM_PLACEMENT   배치 정책 (MM_PLACE_FIRST / MM_PLACE_NEXT / MM_PLACE_BEST /
+ *                  MM_PLACE_BINS)
+ *   MM_MIN_SPLIT   남는 부분이 이 크기 이상일 때만 블록을 분할
+ *   MM_SIZE_CLASSES 요청 크기를 올림할 크기 클래스 목록 (예: 16,32,64)
+ *   MM_PREFETCH    블록 탐색/병합에서 다음 헤더를 미리 prefetch (기본 1)
+ *   MM_SIMD_COPY   realloc의 큰 복사를 SIMD non-temporal store로 (기본 1, x86만)
+ *   MM_NT_THRESHOLD 이 바이트 이상의 복사만 non-temporal로 (그 아래는 memcpy).
+ *                  MM_REMAP_THRESHOLD 이상 옮기는 realloc은 페이지를 옮기는 쪽이
+ *                  우선이라, 기본 빌드에서는 mem_remap이 페이지를 못 옮기고
+ *                  복사할 때(hugetlb 힙 등)만 쓰임
+ *   MM_REMAP_THRESHOLD realloc에서 이 바이트 이상 옮길 때는 복사 대신 페이지를
+ *                  mremap으로 옮김 (0이면 끔, 실시간 모드는 항상 복사)
+ *   MM_SPAN_SIZE   작은 블록과 mm_malloc_hint 블록을 이 크기의 스팬에 따로 모음
+ *                  (0이면 끔, MM_PLACE_BINS만)
+ *   MM_SPAN_SMALL  이 크기 이하 블록이 작은 블록 스팬으로
+ *   MM_NURSERY     크기 클래스/힌트별로 수명을 배워서 짧게 사는 블록을 nursery
+ *                  스팬에 모음 (기본 0, MM_SPAN_SIZE 필요)
+ *   MM_NURSERY_AGE 이 횟수의 malloc 안에 free되면 짧게 산 것으로 침
+ *   MM_COMPACT_LINKS 빈 블록 링크를 포인터 대신 32비트 오프셋으로 (기본 1,
+ *                  MM_PLACE_BINS와 실시간 모드)
+ *   MM_REALTIME    TLSF 실시간 모드 (배치 정책 대신 사용)
+ *   MM_HARDEN      헤더/푸터를 힙마다 다른 비밀값과 XOR해서 저장하고, free/realloc
+ *                  에서 헤더-푸터 일치, 이중 free, 다음 블록 헤더를 검사 (기본 0)
+ *   MM_GUARD       memlib 영역에서 힙 끝(페이지 올림) 위를 PROT_NONE으로 막아서 힙
+ *                  밖 쓰기가 바로 죽게 함 (기본 0, MM_HARDEN 필요). 힙이 페이지를
+ *                  넘을 때마다 mprotect를 하므로 처리량이 크게 떨어짐
+ */
+
+/** @brief 배치 정책: 처음 맞는 블록 */
+#define MM_PLACE_FIRST 0
+/** @brief 배치 정책: 마지막으로 찾은 위치부터 이어서 검색 */
+#define MM_PLACE_NEXT 1
+/** @brief 배치 정책: 가장 작은 맞는 블록 */
+#define MM_PLACE_BEST 2
+/** @brief 배치 정책: 크기별 빈 블록 bin + 비어있지 않은 bin 비트맵 */
+#define MM_PLACE_BINS 3
+
+/** @brief 확장 정책: MAX(요청, MM_CHUNKSIZE)만큼 */
+#define MM_GROW_CHUNK 0
+/** @brief 확장 정책: 요청한 만큼만 */
+#define MM_GROW_EXACT 1
+/** @brief 확장 정책: 확장이 잦으면 단위를 두 배씩(MM_GROW_CAP까지), 뜸하면 절반으로 */
+#define MM_GROW_ADAPTIVE 2
+
+#ifndef MM_HDR_BYTES
+#define MM_HDR_BYTES 4
+#endif
+
+#ifndef MM_CHUNKSIZE
+#define MM_CHUNKSIZE (1 << 12)
+#endif
+
+#ifndef MM_GROWTH
+#define MM_GROWTH MM_GROW_ADAPTIVE
+#endif
+
+#ifndef MM_GROW_CAP
+#define MM_GROW_CAP (1 << 16)
+#endif
+
+#ifndef MM_GROW_WINDOW
+#define MM_GROW_WINDOW 32
+#endif
+
+#ifndef MM_PLACEMENT
+#define MM_PLACEMENT MM_PLACE_BINS
+#endif
+
+#ifndef MM_MIN_SPLIT
+#define MM_MIN_SPLIT (4 * MM_HDR_BYTES)
+#endif
+
+#ifndef MM_PREFETCH
+#define MM_PREFETCH 1
+#endif
+
+#ifndef MM_SIMD_COPY
+#define MM_SIMD_COPY 1
+#endif
+
+#ifndef MM_NT_THRESHOLD
+#define MM_NT_THRESHOLD (2 * 1024 * 1024)
+#endif
+
+#ifndef MM_REMAP_THRESHOLD
+#define MM_REMAP_THRESHOLD (256 * 1024)
+#endif
+
+#ifndef MM_COMPACT_LINKS
+#define MM_COMPACT_LINKS 1
+#endif
 
-/** @brief 더블 워드 사이즈 (8바이트) */
-#define DSIZE 8
+#ifndef MM_SPAN_SIZE
+#define MM_SPAN_SIZE 0
+#endif
 
-/** @brief 힙 확장 시 기본 크기 (4KB) */
-#define CHUNKSIZE (1 << 12)
+#ifndef MM_HARDEN
+#define MM_HARDEN 0
+#endif
+
+#ifndef MM_GUARD
+#define MM_GUARD 0
+#endif
+
+#ifndef MM_SPAN_SMALL
+#define MM_SPAN_SMALL 256
+#endif
+
+#ifndef MM_NURSERY
+#define MM_NURSERY 0
+#endif
+
+#ifndef MM_NURSERY_AGE
+#define MM_NURSERY_AGE 512
+#endif
+
+#if MM_HDR_BYTES != 4 && MM_HDR_BYTES != 8
+#error "MM_HDR_BYTES must be 4 or 8"
+#endif
+
+#if MM_MIN_SPLIT < 4 * MM_HDR_BYTES
+#error "MM_MIN_SPLIT is smaller than the minimum block"
+#endif
+
+#if MM_SPAN_SIZE && (defined(MM_REALTIME) || MM_PLACEMENT != MM_PLACE_BINS)
+#error "MM_SPAN_SIZE needs MM_PLACE_BINS"
+#endif
+
+#if MM_NURSERY && !MM_SPAN_SIZE
+#error "MM_NURSERY needs MM_SPAN_SIZE"
+#endif
+
+/** @brief 헤더/푸터 한 칸의 타입 */
+#if MM_HDR_BYTES == 8
+typedef uint64_t word_t;
+#else
+typedef uint32_t word_t;
+#endif
+
+/** @brief 워드 사이즈 (헤더/푸터 크기, 기본 4바이트) */
+#define WSIZE MM_HDR_BYTES
+
+/** @brief 더블 워드 사이즈 (기본 8바이트) */
+#define DSIZE (2 * WSIZE)
+
+/** @brief 힙 확장 시 기본 크기 (기본 4KB) */
+#define CHUNKSIZE MM_CHUNKSIZE
+
+/**
+ * @brief 주소 p를 캐시로 미리 불러오라고 요청 (결과를 기다리지 않음)
+ * @note 블록 탐색은 헤더를 읽어야 다음 주소를 아는 포인터 체이스라,
+ *       다음 헤더의 캐시 미스를 현재 블록 검사와 겹치게 하려는 것
+ */
+#if MM_PREFETCH
+#define PREFETCH(p) __builtin_prefetch(p)
+#else
+#define PREFETCH(p) ((void)(p))
+#endif
 
 /** @brief 두 인자 중 큰 값을 반환 */
 #define MAX(x, y) ((x) > (y) ? (x) : (y))
 
+/** @brief 두 인자 중 작은 값을 반환 */
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+
 /** 
  * @brief 크기와 할당 여부(0 또는 1)를 하나의 워드로 묶음 
  * @param size 블록 크기
@@ -26,11 +200,22 @@
  */
 #define PACK(size, alloc) ((size) | (alloc))
 
+#if MM_HARDEN
+/**
+ * @brief 주소 p가 가리키는 워드 읽기 (힙의 비밀값과 XOR해서 저장돼 있음)
+ * @note 넘친 쓰기로 덮인 헤더는 풀면 엉뚱한 값이 되어 푸터와 맞지 않음
+ */
+#define GET(p) (*(word_t *)(p) ^ heap_key)
+
+/** @brief 주소 p가 가리키는 워드에 값 쓰기 (비밀값과 XOR해서) */
+#define PUT(p, val) (*(word_t *)(p) = (word_t)(val) ^ heap_key)
+#else
 /** @brief 주소 p가 가리키는 워드 읽기 */
-#define GET(p) (*(unsigned int *)(p))
+#define GET(p) (*(word_t *)(p))
 
 /** @brief 주소 p가 가리키는 워드에 값 쓰기 */
-#define PUT(p, val) (*(unsigned int *)(p) = (val))
+#define PUT(p, val) (*(word_t *)(p) = (val))
+#endif
 
 /** @brief 헤더나 푸터에서 블록 크기 추출 */
 #define GET_SIZE(p) (GET(p) & ~0x7)
@@ -38,6 +223,17 @@
 /** @brief 헤더나 푸터에서 할당 여부 추출 */
 #define GET_ALLOC(p) (GET(p) & 0x1)
 
+#if MM_SPAN_SIZE
+/** @brief 헤더나 푸터에서 블록이 속한 band 추출 (비트 1~2) */
+#define GET_BAND(p) ((GET(p) >> 1) & 0x3)
+
+/** @brief 크기, band, 할당 비트를 한 워드로 합치기 */
+#define PACK_BAND(size, band, alloc) ((size) | ((band) << 1) | (alloc))
+#else
+#define GET_BAND(p) 0
+#define PACK_BAND(size, band, alloc) ((void)(band), PACK(size, alloc))
+#endif
+
 /** 
  * @brief 블록 포인터 bp 기준 헤더 주소 반환
  * @note bp는 payload의 시작 주소
@@ -56,17 +252,164 @@
 /** @brief 이전 블록의 payload 포인터 반환 */
 #define PREV_BLKP(bp) ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)))
 
-/** @brief 정렬 기준 크기 (8바이트 단위) */
+/** @brief 정렬 기준 크기 (기본 8바이트, config.h처럼 -DALIGNMENT=16으로 바꿀 수 있음) */
+#ifndef ALIGNMENT
 #define ALIGNMENT 8
+#endif
+
+/** @brief ALIGNMENT의 log2 (하위 3비트는 헤더 플래그라 8 이상만) */
+#if ALIGNMENT == 8
+#define ALIGN_LOG2 3
+#elif ALIGNMENT == 16
+#define ALIGN_LOG2 4
+#elif ALIGNMENT == 32
+#define ALIGN_LOG2 5
+#else
+#error "ALIGNMENT must be 8, 16 or 32"
+#endif
 
-/** @brief 주어진 size를 8바이트 단위로 정렬 */
-#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~0x7)
+/** @brief 주어진 size를 ALIGNMENT 단위로 정렬 */
+#define ALIGN(size) (((size) + (ALIGNMENT - 1)) & ~(size_t)(ALIGNMENT - 1))
+
+/** @brief 패딩 + 프롤로그 + 에필로그 (첫 블록 payload가 ALIGNMENT에 맞도록 패딩을 늘림) */
+#define PROLOGUE_SIZE ALIGN(4 * WSIZE)
 
 /** @brief size_t 타입 크기를 8바이트로 정렬한 값 */
 #define SIZE_T_SIZE (ALIGN(sizeof(size_t)))
 
-/** @brief 프롤로그(payload 시작 부분)를 가리키는 전역 포인터 */
-static char *heap_listp = 0;
+#ifdef MM_REALTIME
+/** @brief sl 클래스 수의 log2 (기본: fl 구간 하나를 16등분) */
+#ifdef MM_SL_LOG2
+#define SL_LOG2 MM_SL_LOG2
+#else
+#define SL_LOG2 4
+#endif
+
+/** @brief fl 구간 하나의 sl 클래스 수 */
+#define SL_COUNT (1 << SL_LOG2)
+
+/** @brief SMALL_SIZE의 log2 (ALIGNMENT x SL_COUNT) */
+#define FL_SHIFT (SL_LOG2 + ALIGN_LOG2)
+
+/** @brief 이 크기 미만은 모두 fl 0에서 ALIGNMENT 단위로 나눔 */
+#define SMALL_SIZE (1 << FL_SHIFT)
+
+/** @brief fl 클래스 수 (32비트 블록 크기까지) */
+#define FL_COUNT (32 - FL_SHIFT + 1)
+
+#endif
+
+/** @brief MM_PLACE_BINS의 bin 개수 (bin_map 한 워드의 비트 수) */
+#define BIN_COUNT 64
+
+/** @brief 이 크기 미만은 8바이트마다 bin 하나 (bin 0~31) */
+#define BIN_SMALL 256
+
+/** @brief 크기 구간 bin에서 맞는 블록을 찾아 볼 최대 블록 수 */
+#define BIN_SCAN 8
+
+/** @brief band: 일반 블록 (스팬을 쓰지 않으면 모든 블록) */
+#define BAND_GENERAL 0
+
+/** @brief band: MM_SPAN_SMALL 이하 블록의 스팬 */
+#define BAND_SMALL 1
+
+/** @brief band: mm_malloc_hint 블록의 스팬 (힌트마다 BAND_HINT 이상 중 하나) */
+#define BAND_HINT 2
+
+/** @brief band: 짧게 살 것으로 예측한 블록의 스팬 (MM_NURSERY) */
+#define BAND_NURSERY 3
+
+#if MM_SPAN_SIZE
+#define BAND_COUNT 4
+#else
+#define BAND_COUNT 1
+#endif
+
+/** @brief 힌트 스팬에 쓰는 band 수 (nursery가 마지막 band를 가져감) */
+#if MM_NURSERY
+#define HINT_BANDS (BAND_NURSERY - BAND_HINT)
+#else
+#define HINT_BANDS (BAND_COUNT - BAND_HINT)
+#endif
+
+#if MM_NURSERY
+/** @brief 수명 클래스 수: 힌트 없는 블록은 bin마다, 힌트 블록은 힌트 % BIN_COUNT마다 */
+#define LT_CLASSES (2 * BIN_COUNT)
+
+/** @brief 수명을 재는 표본 테이블 크기 (2의 거듭제곱) */
+#define LT_SAMPLES 256
+
+/** @brief 수명 점수의 범위 (양수면 짧게 삶) */
+#define LT_SCORE_MAX 15
+#define LT_SCORE_MIN (-16)
+
+/** @brief 수명 표본 하나: 블록, 만들어진 시각(malloc 횟수), 수명 클래스 */
+typedef struct
+{
+    char *bp;
+    unsigned int birth;
+    unsigned char cls;
+} lt_sample_t;
+#endif
+
+/**
+ * @brief 힙 하나의 상태 (mm_heap_create로 여러 개를 만들 수 있음)
+ * @note mm_* 함수는 모두 heap이 가리키는 힙에서 동작하고, mm_heap_* 함수는
+ *       heap과 memlib 영역을 그 힙의 것으로 잠깐 바꿔서 mm_*를 부름
+ */
+struct mm_heap
+{
+    char *heap_listp;     /**< 프롤로그(payload 시작 부분) */
+    mem_region_t *region; /**< 힙이 쓰는 memlib 영역 (기본 힙은 NULL = mem_init의 영역) */
+#if !defined(MM_REALTIME) && MM_PLACEMENT == MM_PLACE_NEXT
+    char *rover; /**< next fit 검색을 이어서 시작할 블록 */
+#endif
+#if !defined(MM_REALTIME) && MM_PLACEMENT == MM_PLACE_BINS
+    uint64_t bin_map[BAND_COUNT];         /**< band마다 비어있지 않은 bin 비트맵 */
+    char *bins[BAND_COUNT][BIN_COUNT];    /**< band, bin별 빈 블록 리스트의 head */
+#endif
+#if MM_NURSERY
+    unsigned int lt_clock;                /**< 지금까지의 malloc 횟수 (수명의 단위) */
+    signed char lt_score[LT_CLASSES];     /**< 수명 클래스별 점수 (양수면 nursery로) */
+    lt_sample_t lt_samples[LT_SAMPLES];   /**< 블록 주소로 고른 칸의 수명 표본 */
+#endif
+#if MM_GROWTH == MM_GROW_ADAPTIVE
+    size_t grow_chunk;               /**< 적응형 확장의 현재 단위 */
+    unsigned int mallocs_since_grow; /**< 마지막 힙 확장 이후의 malloc 호출 수 */
+#endif
+    uintptr_t *handles;     /**< 핸들 테이블: 블록 bp, 빈 칸은 (다음 빈 칸 << 1) | 1 */
+    size_t handle_count;    /**< 쓴 적 있는 칸 수 (0번 칸은 MM_HANDLE_NONE이라 안 씀) */
+    size_t handle_cap;      /**< 테이블 크기 */
+    size_t handle_free;     /**< 빈 칸 리스트의 head (0이면 없음) */
+    char *compact_cursor;   /**< 압축을 이어서 할 블록 (NULL이면 힙 처음부터) */
+    unsigned int compact_rate; /**< 블록을 옮기는 데 드는 시간 추정 (바이트당 피코초) */
+    int compact_trim;       /**< 힙 끝까지 갔지만 시간이 없어 다음 호출로 미룬 mm_trim */
+    char *move_bp;          /**< 여러 호출에 걸쳐 옮기는 중인 핸들 블록의 새 bp (NULL이면 없음) */
+    size_t move_gap;        /**< 그 블록 앞에 있던 빈 블록의 크기 (= 옮기는 거리) */
+    size_t move_done;       /**< 지금까지 복사한 payload 바이트 */
+    mm_handle_t move_handle; /**< 옮기는 중인 블록의 핸들 */
+#if MM_HARDEN
+    word_t secret;          /**< 헤더/푸터에 XOR하는 값 (mm_init마다 새로) */
+    char *heap_end;         /**< mem_heap_hi() + 1 (free마다 memlib을 부르지 않도록) */
+#endif
+#ifdef MM_REALTIME
+    unsigned int fl_bitmap;               /**< 비어있지 않은 fl 클래스 비트맵 */
+    unsigned int sl_bitmap[FL_COUNT];     /**< fl 클래스마다 비어있지 않은 sl 클래스 비트맵 */
+    char *free_lists[FL_COUNT][SL_COUNT]; /**< 클래스별 빈 블록 리스트의 head */
+#endif
+};
+
+/** @brief mm_init/mm_malloc이 쓰는 기본 힙 */
+static mm_heap_t default_heap;
+
+/** @brief 지금 동작 중인 힙 */
+static mm_heap_t *heap = &default_heap;
+
+#if MM_HARDEN
+/** @brief 동작 중인 힙의 secret 사본 (GET/PUT마다 heap을 거쳐 읽지 않도록) */
+static word_t heap_key;
+#endif
 
 /** 
  * @brief 팀 정보 구조체 (malloc lab 제출용)
@@ -91,182 +434,1714 @@ static void *extend_heap(size_t words);
 /// @return 병합한 블록의 payload 포인터
 static void *coalesce(char *bp);
 
-static void* coalesce(char *bp)
+#if MM_GROWTH == MM_GROW_ADAPTIVE
+/** @brief malloc 호출 한 번을 셈 */
+#define COUNT_MALLOC() (heap->mallocs_since_grow++)
+
+/** @brief mm_init에서 확장 상태를 처음으로 되돌림 */
+#define RESET_GROWTH() (heap->grow_chunk = CHUNKSIZE, heap->mallocs_since_grow = 0)
+#else
+#define COUNT_MALLOC()
+#define RESET_GROWTH()
+#endif
+
+/// @brief asize 블록을 만들려면 힙을 몇 바이트 늘려야 하는지 정하는 함수
+/// @note 힙 끝 블록이 비어있으면 확장분과 병합되므로 모자란 만큼만 계산함
+///       (TLSF는 올림 검색 때문에 asize 이상인 끝 블록을 못 찾을 수 있어 크기도 확인)
+static size_t heap_growth(size_t asize)
 {
-    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
-    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
-    size_t size = GET_SIZE(HDRP(bp));
+    char *last = PREV_BLKP((char *)mem_heap_hi() + 1); // 에필로그 바로 앞 블록
+    size_t need = asize;
 
-    if (prev_alloc && next_alloc) // 앞 뒤에 빈 블록이 없을 때
+    // 새 공간과 병합될 마지막 빈 블록(일반 band)만큼은 덜 늘림
+    if (!GET_ALLOC(HDRP(last)) && GET_BAND(HDRP(last)) == BAND_GENERAL && GET_SIZE(HDRP(last)) < asize)
     {
-        return bp;
+        need -= GET_SIZE(HDRP(last));
     }
-    else if (prev_alloc && !next_alloc) // 뒤에 블록만 비어있을 때
+#if MM_GROWTH == MM_GROW_EXACT
+    return need;
+#elif MM_GROWTH == MM_GROW_ADAPTIVE
+    if (heap->mallocs_since_grow < MM_GROW_WINDOW) // 확장이 잦음 -> 단위를 키움
     {
-        size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(bp), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-        return bp;
+        heap->grow_chunk = MIN(2 * heap->grow_chunk, MM_GROW_CAP);
     }
-    else if (!prev_alloc && next_alloc) // 앞의 블록만 비어있을 때
+    else if (heap->mallocs_since_grow > 4 * MM_GROW_WINDOW) // 뜸함 -> 줄임
     {
-        size += GET_SIZE(HDRP(PREV_BLKP(bp)));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-        return PREV_BLKP(bp);
+        heap->grow_chunk = MAX(heap->grow_chunk / 2, CHUNKSIZE);
     }
-    else // 앞과 뒤 블록 다 비어있을 때
+    heap->mallocs_since_grow = 0;
+    return MAX(need, heap->grow_chunk); // 큰 요청은 필요한 만큼만 (넘치지 않게)
+#else
+    return MAX(need, CHUNKSIZE);
+#endif
+}
+
+#ifdef MM_SIZE_CLASSES
+/** @brief 크기 클래스 목록 (블록 크기, 오름차순, ALIGNMENT의 배수) */
+static const size_t size_classes[] = {MM_SIZE_CLASSES};
+
+/** @brief 크기 클래스 수 */
+#define NUM_CLASSES (sizeof(size_classes) / sizeof(size_classes[0]))
+
+/// @brief 블록 크기를 그 이상인 가장 작은 크기 클래스로 올림하는 함수
+/// @note 목록이 상수라 컴파일러가 루프를 비교 몇 번으로 펼침
+static size_t class_size(size_t asize)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_CLASSES; i++)
     {
-        size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
-        PUT(FTRP(NEXT_BLKP(bp)), PACK(size, 0));
-        return PREV_BLKP(bp);
+        if (asize <= size_classes[i])
+        {
+            return ALIGN(size_classes[i]);
+        }
     }
+    return asize; // 가장 큰 클래스보다 크면 그대로
 }
+#else
+#define class_size(asize) (asize)
+#endif
 
-static void *extend_heap(size_t words)
+#if MM_SIMD_COPY && (defined(__x86_64__) || defined(__i386__))
+/// @brief n바이트를 AVX2 non-temporal store로 복사하는 함수
+/// @note 쓴 데이터를 캐시에 남기지 않으므로, 캐시보다 큰 복사에서
+///       다른 블록이 밀려나지 않고 read-for-ownership도 생략됨
+__attribute__((target("avx2")))
+static void copy_nt_avx2(char *dst, const char *src, size_t n)
 {
-    char *bp;
-    size_t size;
+    size_t head = (32 - ((uintptr_t)dst & 31)) & 31; // dst를 32바이트 경계로 맞춤
 
-    /* alignment 유지를 위해 짝수 개수의 words를 allocate */
-    size = (words % 2) ? (words + 1) * WSIZE : words * WSIZE;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    n -= head;
+    for (; n >= 128; n -= 128, dst += 128, src += 128)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)src);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(src + 96));
+        _mm256_stream_si256((__m256i *)dst, a);
+        _mm256_stream_si256((__m256i *)(dst + 32), b);
+        _mm256_stream_si256((__m256i *)(dst + 64), c);
+        _mm256_stream_si256((__m256i *)(dst + 96), d);
+    }
+    _mm_sfence(); // stream store가 이후 읽기보다 먼저 보이도록
+    memcpy(dst, src, n);
+}
 
-    if ((long)(bp = mem_sbrk(size)) == -1)
-        return NULL;
+/// @brief copy_nt_avx2와 같지만 SSE2(16바이트)로 복사하는 함수 (AVX2가 없는 CPU용)
+__attribute__((target("sse2")))
+static void copy_nt_sse2(char *dst, const char *src, size_t n)
+{
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
 
-    /* 새 free 블록의 헤더/푸터, 그리고 새 에필로그 설정 */
-    PUT(HDRP(bp), PACK(size, 0));          /* Free block header   (bp는 payload 포인터로 취급) */
-    PUT(FTRP(bp), PACK(size, 0));          /* Free block footer */
-    PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 1));  /* New epilogue header */
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    n -= head;
+    for (; n >= 64; n -= 64, dst += 64, src += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)src);
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)dst, a);
+        _mm_stream_si128((__m128i *)(dst + 16), b);
+        _mm_stream_si128((__m128i *)(dst + 32), c);
+        _mm_stream_si128((__m128i *)(dst + 48), d);
+    }
+    _mm_sfence();
+    memcpy(dst, src, n);
+}
 
-    /* 직전 블록이 free였다면 병합 */
-    return coalesce(bp);
+/** @brief 실행 중인 CPU에 맞는 non-temporal 복사 함수 (처음 쓸 때 cpuid로 고름) */
+static void (*copy_nt)(char *, const char *, size_t);
+
+/// @brief realloc의 payload 복사 함수: 큰 복사는 non-temporal로, 나머지는 memcpy로
+static void block_copy(void *dst, const void *src, size_t n)
+{
+    if (n < MM_NT_THRESHOLD)
+    {
+        memcpy(dst, src, n);
+        return;
+    }
+    if (copy_nt == NULL)
+    {
+        __builtin_cpu_init();
+        copy_nt = __builtin_cpu_supports("avx2") ? copy_nt_avx2 : copy_nt_sse2;
+    }
+    copy_nt(dst, src, n);
+}
+#else
+/// @brief realloc의 payload 복사 함수 (SIMD 복사를 끈 빌드는 memcpy 그대로)
+static void block_copy(void *dst, const void *src, size_t n)
+{
+    memcpy(dst, src, n);
 }
+#endif
 
-/// @brief 힙을 초기화 하는 함수
-/// @param  
-/// @return 성공 여부 : -1(fail) / 0(success)
-int mm_init(void)
+/*
+ * 빈 블록 링크 (MM_PLACE_BINS, 실시간 모드)
+ *
+ * MM_COMPACT_LINKS이면 next/prev를 8바이트 포인터 대신 heap_listp로부터의
+ * 32비트 오프셋으로 저장한다. heap_listp는 프롤로그라 빈 블록이 될 수
+ * 없으므로 오프셋 0을 NULL로 쓴다. memlib 힙은 MAX_HEAP(20MB)을 넘지 않아
+ * 32비트로 충분하고, 4바이트 헤더에서 최소 블록이 [헤더][next][prev][푸터]
+ * = 16바이트로 링크가 없는 implicit 리스트와 같아진다.
+ */
+#if MM_COMPACT_LINKS
+typedef uint32_t link_t;
+
+/// @brief 블록 포인터를 링크로 바꾸는 함수 (NULL -> 0)
+static inline link_t to_link(char *p)
 {
-    if ((heap_listp = mem_sbrk(WSIZE * 4)) == (void *)-1)
-        return -1;
+    return p == NULL ? 0 : (link_t)(p - heap->heap_listp);
+}
 
-    PUT(heap_listp, 0); // 패딩
-    PUT(heap_listp + WSIZE, PACK(DSIZE, 1)); // 프롤로그 헤더
-    PUT(heap_listp + DSIZE, PACK(DSIZE, 1)); // 프롤로그 푸터
-    PUT(heap_listp + 3*WSIZE, PACK(0, 1)); // 에필로그 헤더
-    heap_listp += (2*WSIZE); // 프롤로그 payload 가리키도록 바꾸기
+/// @brief 링크를 블록 포인터로 바꾸는 함수 (0 -> NULL)
+static inline char *from_link(link_t l)
+{
+    return l == 0 ? NULL : heap->heap_listp + l;
+}
+#else
+typedef char *link_t;
 
-    if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 힙 확장 -> 4KB
+#define to_link(p) (p)
+#define from_link(l) (l)
+#endif
+
+/// @brief 병합으로 압축 커서가 가리키던 블록이 사라졌으면 병합된 블록 bp로 옮기는 함수
+static inline void fix_cursor(char *bp)
+{
+    if (heap->compact_cursor > bp && heap->compact_cursor < NEXT_BLKP(bp))
     {
-        return -1; // 힙 확장 실패
+        heap->compact_cursor = bp;
     }
+}
 
-    return 0; // 힙 확장 성공
+/** @brief 압축 속도의 처음 추정 (바이트당 피코초, 4GB/s로 느리게 잡음) */
+#define COMPACT_RATE_INIT 250
+
+/** @brief 압축 속도를 잴 때 쓰는 가장 작은 블록 (바이트) */
+#define COMPACT_RATE_MIN 1024
+
+/** @brief 한 번 잰 속도의 상한 (인터럽트 한 번으로 추정이 튀지 않도록) */
+#define COMPACT_RATE_MAX 4000
+
+/// @brief 핸들 테이블과 압축 커서를 비우는 함수 (mm_init에서, 옛 힙의 핸들은 모두 무효)
+static void reset_handles(void)
+{
+    free(heap->handles);
+    heap->handles = NULL;
+    heap->handle_count = heap->handle_cap = heap->handle_free = 0;
+    heap->compact_cursor = NULL;
+    heap->compact_rate = COMPACT_RATE_INIT;
+    heap->compact_trim = 0;
+    heap->move_bp = NULL;
 }
 
-/// @brief malloc 함수
-/// @param size 할당 받을 크기
-/// @return 할당 받을 블록의 payload
-void *mm_malloc(size_t size)
+/// @brief 지금 시각 (나노초)
+static long long now_ns(void)
 {
-    size_t reqsize; // 요구 받은 사이즈를 정렬한 사이즈
-    char *bp; // 리턴할 블록 payload의 포인터
+    struct timespec ts;
 
-    if (size == 0) // 요구 사이즈 = 0
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+#if MM_HARDEN
+/// @brief 새 힙의 비밀값을 정하고 (MM_GUARD면) memlib 영역에 guard page를 켜는 함수 (mm_init에서)
+static void harden_init(void)
+{
+    if (getrandom(&heap->secret, sizeof(heap->secret), GRND_NONBLOCK) != sizeof(heap->secret))
     {
-        return NULL;
+        heap->secret = (word_t)(now_ns() ^ (uintptr_t)heap);
     }
+    heap_key = heap->secret;
+#if MM_GUARD
+    mem_set_guard(1);
+#endif
+}
 
-    reqsize = size <= DSIZE ? 2 * DSIZE :  ALIGN(size + 2 * WSIZE); // 요구 사이즈를 정렬
-    // 요구 사이즈가 DSIZE보다 작거나 같으면 최소 16바이트로 정렬, 아니면 WSIZE의 배수로 정렬
+/// @brief 힙이 깨진 것을 알리고 멈추는 함수
+static void heap_corrupt(const char *fn, const char *what, void *ptr)
+{
+    fprintf(stderr, "%s: %s (%p)\n", fn, what, ptr);
+    abort();
+}
 
-    for (bp = NEXT_BLKP(heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
-    {
-        if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) >= reqsize) 
-        {
-            size_t blockSize = GET_SIZE(HDRP(bp));
-            if (blockSize - reqsize >= 2 * DSIZE) 
-            {
-                PUT(HDRP(bp), PACK(reqsize, 1));
-                PUT(FTRP(bp), PACK(reqsize, 1));
+/// @brief free/realloc에 넘어온 블록 ptr의 헤더, 푸터와 다음 블록 헤더를 검사하는 함수
+/// @note 블록 끝을 넘쳐 쓰면 다음 블록 헤더가 깨지므로, 넘친 블록을 free할 때 잡힘.
+///       덮인 헤더는 비밀값과 XOR해서 풀면 거의 항상 힙을 벗어나는 크기가 되므로
+///       다음 블록은 (멀리 있을 수 있는) 푸터를 읽지 않고 크기만 봄
+static inline void check_block(const char *fn, char *ptr)
+{
+    char *hi = heap->heap_end;
+    size_t size;
+    char *next;
 
-                char *next_bp = NEXT_BLKP(bp);
-                PUT(HDRP(next_bp), PACK(blockSize - reqsize, 0));
-                PUT(FTRP(next_bp), PACK(blockSize - reqsize, 0));
-            }
-            else 
-            {
-                PUT(HDRP(bp), PACK(blockSize, 1));
-                PUT(FTRP(bp), PACK(blockSize, 1));
-            }
-            return bp;
-        }
+    if (ptr <= heap->heap_listp || ptr >= hi || ((uintptr_t)ptr & (ALIGNMENT - 1)))
+    {
+        heap_corrupt(fn, "pointer outside the heap", ptr);
     }
-
-    bp = extend_heap(MAX(reqsize, CHUNKSIZE) / WSIZE);
-    if (bp == NULL)
+    size = GET_SIZE(HDRP(ptr));
+    if (size < DSIZE || size > (size_t)(hi - ptr) || GET(FTRP(ptr)) != GET(HDRP(ptr)))
     {
-        return NULL;
+        heap_corrupt(fn, "corrupted block header or footer", ptr);
     }
-    size_t blockSize = GET_SIZE(HDRP(bp));
-    if (blockSize - reqsize >= 2 * DSIZE) 
+    if (!GET_ALLOC(HDRP(ptr)))
     {
-        PUT(HDRP(bp), PACK(reqsize, 1));
-        PUT(FTRP(bp), PACK(reqsize, 1));
-
-        char *next_bp = NEXT_BLKP(bp);
-        PUT(HDRP(next_bp), PACK(blockSize - reqsize, 0));
-        PUT(FTRP(next_bp), PACK(blockSize - reqsize, 0));
-    } 
-    else 
+        heap_corrupt(fn, "double free", ptr);
+    }
+    next = NEXT_BLKP(ptr);
+    size = GET_SIZE(HDRP(next));
+    if (size == 0 ? next != hi || !GET_ALLOC(HDRP(next)) : size < DSIZE || size > (size_t)(hi - next))
     {
-        PUT(HDRP(bp), PACK(blockSize, 1));
-        PUT(FTRP(bp), PACK(blockSize, 1));
+        heap_corrupt(fn, "overflow into the next block", ptr);
     }
-
-    return bp;
 }
 
-void mm_free(void *ptr)
+#define HARDEN_INIT() harden_init()
+#define CHECK_BLOCK(fn, ptr) check_block(fn, (char *)(ptr))
+#define SET_HEAP_END(end) (heap->heap_end = (end))
+#else
+#define HARDEN_INIT()
+#define CHECK_BLOCK(fn, ptr)
+#define SET_HEAP_END(end)
+#endif
+
+/** @brief 링크가 있는 빈 블록의 최소 크기: 헤더 + next + prev + 푸터를 정렬 */
+#define LINKED_MIN_BLOCK ALIGN(2 * WSIZE + 2 * sizeof(link_t))
+
+/** @brief 빈 블록 bp의 다음 빈 블록 */
+#define NEXT_FREE(bp) from_link(*(link_t *)(bp))
+
+/** @brief 빈 블록 bp의 이전 빈 블록 */
+#define PREV_FREE(bp) from_link(*((link_t *)(bp) + 1))
+
+/** @brief 빈 블록 bp의 다음 빈 블록을 p로 */
+#define SET_NEXT_FREE(bp, p) (*(link_t *)(bp) = to_link(p))
+
+/** @brief 빈 블록 bp의 이전 빈 블록을 p로 */
+#define SET_PREV_FREE(bp, p) (*((link_t *)(bp) + 1) = to_link(p))
+
+#ifdef MM_REALTIME
+/*
+ * 실시간 모드 (make mdriver-rt): TLSF (Two-Level Segregated Fit)
+ *
+ * 빈 블록을 크기별 2단계 클래스(fl: 2의 거듭제곱 구간, sl: 그 구간을
+ * SL_COUNT 등분)의 이중 연결 리스트에 나눠 담고, 비어있지 않은 리스트를
+ * 비트맵으로 표시한다. 검색은 비트맵에 ffs/clz 한두 번이면 끝나고,
+ * 리스트 삽입/삭제와 병합도 상수 시간이라 malloc/free에 힙 크기에 비례하는
+ * 루프가 없다. (realloc은 복사 때문에 블록 크기에 비례)
+ *
+ * 빈 블록 레이아웃: [헤더][next][prev] ... [푸터] (링크는 위의 link_t)
+ */
+
+/** @brief 최소 블록 크기 */
+#define MIN_BLOCK LINKED_MIN_BLOCK
+
+/// @brief 블록 크기가 속한 (fl, sl) 클래스를 구하는 함수
+/// @param size 블록 크기
+/// @param fl fl 클래스 (출력)
+/// @param sl sl 클래스 (출력)
+static void mapping_insert(size_t size, int *fl, int *sl)
 {
-    if (ptr == NULL)
+    int msb;
+
+    if (size < SMALL_SIZE)
     {
+        *fl = 0;
+        *sl = size >> ALIGN_LOG2;
         return;
     }
+    msb = 31 - __builtin_clz((unsigned int)size); // 최상위 비트 위치
+    *sl = (size >> (msb - SL_LOG2)) ^ SL_COUNT;
+    *fl = msb - (FL_SHIFT - 1);
+}
 
-    size_t size = GET_SIZE(HDRP(ptr));
-    PUT(HDRP(ptr), PACK(size, 0));
-    PUT(FTRP(ptr), PACK(size, 0));
-    coalesce((char *)ptr);
+/// @brief size 이상의 블록만 들어있는 첫 클래스를 구하는 함수
+/// @note size를 다음 sl 경계로 올림해서, 찾은 리스트의 어떤 블록이든 맞게 함
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+    if (size >= SMALL_SIZE)
+    {
+        size += (1 << (31 - __builtin_clz((unsigned int)size) - SL_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
 }
 
-void *mm_realloc(void *ptr, size_t size)
+/// @brief 빈 블록을 해당 클래스 리스트의 맨 앞에 넣는 함수
+static void insert_free(char *bp)
 {
-    if (ptr == NULL)
+    int fl, sl;
+
+    mapping_insert(GET_SIZE(HDRP(bp)), &fl, &sl);
+    PREFETCH(heap->free_lists[fl][sl]); // 리스트 head의 prev를 곧 고쳐 씀
+    SET_NEXT_FREE(bp, heap->free_lists[fl][sl]);
+    SET_PREV_FREE(bp, NULL);
+    if (heap->free_lists[fl][sl] != NULL)
     {
-        return mm_malloc(size);
+        SET_PREV_FREE(heap->free_lists[fl][sl], bp);
     }
+    heap->free_lists[fl][sl] = bp;
+    heap->fl_bitmap |= 1u << fl;
+    heap->sl_bitmap[fl] |= 1u << sl;
+}
 
-    if (size == 0)
+/// @brief 빈 블록을 리스트에서 빼는 함수 (리스트가 비면 비트맵도 지움)
+static void remove_free(char *bp)
+{
+    int fl, sl;
+
+    PREFETCH(NEXT_FREE(bp)); // 앞뒤 빈 블록의 링크를 곧 고쳐 씀
+    PREFETCH(PREV_FREE(bp));
+    mapping_insert(GET_SIZE(HDRP(bp)), &fl, &sl);
+    if (PREV_FREE(bp) != NULL)
     {
-        mm_free(ptr);
-        return NULL; 
+        SET_NEXT_FREE(PREV_FREE(bp), NEXT_FREE(bp));
+    }
+    else
+    {
+        heap->free_lists[fl][sl] = NEXT_FREE(bp);
     }
+    if (NEXT_FREE(bp) != NULL)
+    {
+        SET_PREV_FREE(NEXT_FREE(bp), PREV_FREE(bp));
+    }
+    if (heap->free_lists[fl][sl] == NULL)
+    {
+        heap->sl_bitmap[fl] &= ~(1u << sl);
+        if (heap->sl_bitmap[fl] == 0)
+        {
+            heap->fl_bitmap &= ~(1u << fl);
+        }
+    }
+}
 
-    void *newptr = mm_malloc(size);
-    if (newptr == NULL)
+/// @brief asize 이상인 빈 블록을 비트맵으로 찾는 함수 (루프 없음)
+/// @return 찾은 블록 (리스트에 그대로 있음) / 없으면 NULL
+static char *find_fit(size_t asize)
+{
+    int fl, sl;
+    unsigned int map;
+
+    mapping_search(asize, &fl, &sl);
+    if (fl >= FL_COUNT)
     {
         return NULL;
     }
+    map = heap->sl_bitmap[fl] & (~0u << sl); // 같은 fl에서 sl 이상
+    if (map == 0)
+    {
+        map = (fl + 1 < FL_COUNT) ? heap->fl_bitmap & (~0u << (fl + 1)) : 0; // 더 큰 fl
+        if (map == 0)
+        {
+            return NULL;
+        }
+        fl = __builtin_ctz(map);
+        map = heap->sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    return heap->free_lists[fl][sl];
+}
+
+/// @brief 리스트에서 빠진 블록 bp에 asize를 할당하고 나머지를 돌려놓는 함수
+static void place(char *bp, size_t asize)
+{
+    size_t blockSize = GET_SIZE(HDRP(bp));
+
+    if (blockSize - asize >= MIN_BLOCK)
+    {
+        PUT(HDRP(bp), PACK(asize, 1));
+        PUT(FTRP(bp), PACK(asize, 1));
+
+        char *next_bp = NEXT_BLKP(bp);
+        PUT(HDRP(next_bp), PACK(blockSize - asize, 0));
+        PUT(FTRP(next_bp), PACK(blockSize - asize, 0));
+        insert_free(next_bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(blockSize, 1));
+        PUT(FTRP(bp), PACK(blockSize, 1));
+    }
+}
+
+/// @note 실시간 모드에서는 이웃 빈 블록을 리스트에서 뺀 뒤 합치고,
+///       합친 블록은 리스트에 넣지 않고 돌려줌
+static void *coalesce(char *bp)
+{
+    PREFETCH(HDRP(NEXT_BLKP(bp))); // 뒤 블록 헤더
+    PREFETCH(HDRP(PREV_BLKP(bp))); // 앞 블록 헤더 (앞 블록 푸터의 크기로 계산)
+
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
 
-    size_t copySize = GET_SIZE(HDRP(ptr)) - DSIZE;
-    if (size < copySize)
+    if (!next_alloc) // 뒤 블록이 비어있을 때
     {
-        copySize = size;
+        remove_free(NEXT_BLKP(bp));
+        size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        PUT(HDRP(bp), PACK(size, 0));
+        PUT(FTRP(bp), PACK(size, 0));
     }
-    memcpy(newptr, ptr, copySize);
-    mm_free(ptr);
-    return newptr;
-}
\ No newline at end of file
+    if (!prev_alloc) // 앞 블록이 비어있을 때
+    {
+        remove_free(PREV_BLKP(bp));
+        size += GET_SIZE(HDRP(PREV_BLKP(bp)));
+        PUT(FTRP(bp), PACK(size, 0));
+        PUT(HDRP(PREV_BLKP(bp)), PACK(size, 0));
+        bp = PREV_BLKP(bp);
+    }
+    fix_cursor(bp);
+    return bp;
+}
+
+/// @note 새 빈 블록은 (병합 후) 리스트에 넣지 않고 돌려줌
+static void *extend_heap(size_t words)
+{
+    char *bp;
+    size_t size;
+
+    size = ALIGN((words % 2) ? (words + 1) * WSIZE : words * WSIZE);
+
+    if ((long)(bp = mem_sbrk(size)) == -1)
+        return NULL;
+    SET_HEAP_END(bp + size);
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 1));
+
+    return coalesce(bp);
+}
+
+int mm_init(void)
+{
+    char *bp;
+
+    reset_handles();
+    HARDEN_INIT();
+    heap->fl_bitmap = 0;
+    memset(heap->sl_bitmap, 0, sizeof(heap->sl_bitmap));
+    memset(heap->free_lists, 0, sizeof(heap->free_lists));
+    RESET_GROWTH();
+
+    if ((heap->heap_listp = mem_sbrk(PROLOGUE_SIZE)) == (void *)-1)
+        return -1;
+    SET_HEAP_END(heap->heap_listp + PROLOGUE_SIZE);
+    heap->heap_listp += PROLOGUE_SIZE - 4 * WSIZE; // 남는 앞부분은 패딩
+
+    PUT(heap->heap_listp, 0); // 패딩
+    PUT(heap->heap_listp + WSIZE, PACK(DSIZE, 1)); // 프롤로그 헤더
+    PUT(heap->heap_listp + DSIZE, PACK(DSIZE, 1)); // 프롤로그 푸터
+    PUT(heap->heap_listp + 3*WSIZE, PACK(0, 1)); // 에필로그 헤더
+    heap->heap_listp += (2*WSIZE);
+
+    if ((bp = extend_heap(CHUNKSIZE / WSIZE)) == NULL)
+    {
+        return -1;
+    }
+    insert_free(bp);
+    return 0;
+}
+
+/// @brief malloc 함수 (실시간 모드): 비트맵 검색 한 번, 없으면 힙 확장 한 번
+void *mm_malloc(size_t size)
+{
+    size_t asize;
+    char *bp;
+
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    asize = class_size(MAX(ALIGN(size + DSIZE), MIN_BLOCK));
+    COUNT_MALLOC();
+
+    if ((bp = find_fit(asize)) != NULL)
+    {
+        remove_free(bp);
+    }
+    else if ((bp = extend_heap(heap_growth(asize) / WSIZE)) == NULL)
+    {
+        return NULL;
+    }
+    place(bp, asize);
+    return bp;
+}
+
+/// @note 실시간 모드에는 스팬이 없어서 힌트는 무시함
+void *mm_malloc_hint(size_t size, unsigned int hint)
+{
+    (void)hint;
+    return mm_malloc(size);
+}
+
+void mm_free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    CHECK_BLOCK("mm_free", ptr);
+    size_t size = GET_SIZE(HDRP(ptr));
+    PUT(HDRP(ptr), PACK(size, 0));
+    PUT(FTRP(ptr), PACK(size, 0));
+    insert_free(coalesce((char *)ptr));
+}
+
+/// @brief realloc 함수 (실시간 모드): 줄이거나 뒤 빈 블록을 흡수할 수 있으면 제자리에서
+void *mm_realloc(void *ptr, size_t size)
+{
+    size_t asize, oldSize, total;
+    char *next;
+
+    if (ptr == NULL)
+    {
+        return mm_malloc(size);
+    }
+
+    if (size == 0)
+    {
+        mm_free(ptr);
+        return NULL;
+    }
+
+    CHECK_BLOCK("mm_realloc", ptr);
+    asize = class_size(MAX(ALIGN(size + DSIZE), MIN_BLOCK));
+    oldSize = GET_SIZE(HDRP(ptr));
+    next = NEXT_BLKP(ptr);
+    total = oldSize + (GET_ALLOC(HDRP(next)) ? 0 : GET_SIZE(HDRP(next)));
+    if (total >= asize)
+    {
+        if (total > oldSize)
+        {
+            remove_free(next);
+            PUT(HDRP(ptr), PACK(total, 0));
+            fix_cursor(ptr);
+        }
+        place(ptr, asize);
+        return ptr;
+    }
+
+    void *newptr = mm_malloc(size);
+    if (newptr == NULL)
+    {
+        return NULL;
+    }
+    block_copy(newptr, ptr, MIN(oldSize - DSIZE, size));
+    mm_free(ptr);
+    return newptr;
+}
+
+#else /* !MM_REALTIME */
+
+#if MM_PLACEMENT == MM_PLACE_BINS
+/*
+ * MM_PLACE_BINS: 빈 블록을 크기별 bin 64개의 이중 연결 리스트에 나눠 담고,
+ * 비어있지 않은 bin을 64비트 bin_map으로 표시한다. 256바이트 미만은
+ * 8바이트마다 bin 하나(그 bin의 블록은 모두 같은 크기)이고, 그 위는
+ * 2의 거듭제곱 구간을 4등분해서 64KB까지, 그보다 크면 마지막 bin.
+ * 요청 크기의 bin에 맞는 블록이 없으면 그보다 큰 bin 중 가장 작은 것을
+ * ctz 한 번으로 찾으므로, 빈 bin이 많아도 빈 리스트를 차례로 들여다보지 않는다.
+ *
+ * 빈 블록 레이아웃: [헤더][next][prev] ... [푸터] (링크는 위의 link_t)
+ * 빈 블록은 항상 자기 bin에 들어있음: coalesce가 병합한 블록을 넣고,
+ * place가 할당할 블록을 뺀다.
+ *
+ * MM_SPAN_SIZE이면 블록마다 헤더/푸터의 비트 1~2에 band가 있고 band마다
+ * bin이 따로 있다. MM_SPAN_SMALL 이하의 작은 블록(BAND_SMALL)과
+ * mm_malloc_hint로 묶인 블록(BAND_HINT~)은 일반 band에서 MM_SPAN_SIZE씩
+ * 떼어 온 스팬 안에서만 할당되고, 병합도 같은 band끼리만 해서 자주 쓰는
+ * 작은 객체가 큰 버퍼와 캐시 라인/페이지를 나눠 쓰지 않게 한다. 병합한
+ * 빈 블록이 스팬 크기 이상이 되면 일반 band로 돌려준다.
+ */
+
+/** @brief 최소 블록 크기 */
+#define MIN_BLOCK LINKED_MIN_BLOCK
+
+/// @brief 블록 크기가 속한 bin을 구하는 함수
+static inline int bin_index(size_t size)
+{
+    int msb, bin;
+
+    if (size < BIN_SMALL)
+    {
+        return size >> ALIGN_LOG2;
+    }
+    msb = 63 - __builtin_clzll((unsigned long long)size); // 8 이상
+    bin = (BIN_SMALL >> ALIGN_LOG2) + ((msb - 8) << 2) + ((size >> (msb - 2)) & 3);
+    return MIN(bin, BIN_COUNT - 1);
+}
+
+/// @brief 빈 블록을 해당 band, bin 리스트의 맨 앞에 넣는 함수
+static void link_free(char *bp)
+{
+    int band = GET_BAND(HDRP(bp));
+    int bin = bin_index(GET_SIZE(HDRP(bp)));
+
+    SET_NEXT_FREE(bp, heap->bins[band][bin]);
+    SET_PREV_FREE(bp, NULL);
+    if (heap->bins[band][bin] != NULL)
+    {
+        SET_PREV_FREE(heap->bins[band][bin], bp);
+    }
+    heap->bins[band][bin] = bp;
+    heap->bin_map[band] |= 1ULL << bin;
+}
+
+/// @brief 빈 블록을 bin 리스트에서 빼는 함수 (bin이 비면 비트맵도 지움)
+static void unlink_free(char *bp)
+{
+    int band = GET_BAND(HDRP(bp));
+    int bin = bin_index(GET_SIZE(HDRP(bp)));
+
+    if (PREV_FREE(bp) != NULL)
+    {
+        SET_NEXT_FREE(PREV_FREE(bp), NEXT_FREE(bp));
+    }
+    else if ((heap->bins[band][bin] = NEXT_FREE(bp)) == NULL)
+    {
+        heap->bin_map[band] &= ~(1ULL << bin);
+    }
+    if (NEXT_FREE(bp) != NULL)
+    {
+        SET_PREV_FREE(NEXT_FREE(bp), PREV_FREE(bp));
+    }
+}
+#else
+/** @brief 최소 블록 크기: 헤더 + 8바이트 payload + 푸터 */
+#define MIN_BLOCK ALIGN(2 * DSIZE)
+
+#define link_free(bp) ((void)(bp))
+#define unlink_free(bp) ((void)(bp))
+#endif
+
+/** @brief 분할하고 남는 부분의 최소 크기 */
+#define SPLIT_MIN MAX(MM_MIN_SPLIT, MIN_BLOCK)
+
+/// @brief asize 이상인 빈 블록을 MM_PLACEMENT 정책으로 찾는 함수
+/// @param band 찾을 band (MM_SPAN_SIZE가 아니면 항상 BAND_GENERAL)
+/// @return 찾은 블록의 payload 포인터 / 없으면 NULL
+static char *find_fit(size_t asize, int band)
+{
+    char *bp;
+
+#if MM_PLACEMENT == MM_PLACE_BINS
+    int bin = bin_index(asize);
+    int n = (bin == BIN_COUNT - 1) ? -1 : BIN_SCAN; // 마지막 bin은 끝까지
+    uint64_t map;
+
+    // 자기 bin: 8바이트 bin이면 head가 바로 맞고, 구간 bin이면 몇 개만 확인
+    for (bp = heap->bins[band][bin]; bp != NULL && n-- != 0; bp = NEXT_FREE(bp))
+    {
+        if (GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return bp;
+        }
+    }
+    // 더 큰 bin 중 비어있지 않은 가장 작은 bin의 head (그 bin의 블록은 모두 맞음)
+    map = (bin + 1 < BIN_COUNT) ? heap->bin_map[band] & (~0ULL << (bin + 1)) : 0;
+    if (map == 0)
+    {
+        return NULL;
+    }
+    return heap->bins[band][__builtin_ctzll(map)];
+#elif MM_PLACEMENT == MM_PLACE_NEXT
+    (void)band;
+    for (bp = heap->rover; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp)) // heap->rover부터 끝까지
+    {
+        PREFETCH(HDRP(NEXT_BLKP(bp)));
+        if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return heap->rover = bp;
+        }
+    }
+    for (bp = NEXT_BLKP(heap->heap_listp); bp < heap->rover; bp = NEXT_BLKP(bp)) // 처음부터 heap->rover까지
+    {
+        PREFETCH(HDRP(NEXT_BLKP(bp)));
+        if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return heap->rover = bp;
+        }
+    }
+    return NULL;
+#elif MM_PLACEMENT == MM_PLACE_BEST
+    char *best = NULL;
+
+    (void)band;
+    for (bp = NEXT_BLKP(heap->heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        PREFETCH(HDRP(NEXT_BLKP(bp))); // 다음 블록 헤더
+        if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) >= asize &&
+            (best == NULL || GET_SIZE(HDRP(bp)) < GET_SIZE(HDRP(best))))
+        {
+            best = bp;
+            if (GET_SIZE(HDRP(bp)) == asize) // 딱 맞으면 더 볼 필요 없음
+            {
+                break;
+            }
+        }
+    }
+    return best;
+#else
+    (void)band;
+    for (bp = NEXT_BLKP(heap->heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        PREFETCH(HDRP(NEXT_BLKP(bp))); // 다음 블록 헤더
+        if (!GET_ALLOC(HDRP(bp)) && GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return bp;
+        }
+    }
+    return NULL;
+#endif
+}
+
+/// @brief 빈 블록 bp에 asize를 할당하고, 남는 부분이 MM_MIN_SPLIT 이상이면 분할하는 함수
+static void place(char *bp, size_t asize)
+{
+    size_t blockSize = GET_SIZE(HDRP(bp));
+    size_t band = GET_BAND(HDRP(bp));
+
+    unlink_free(bp);
+    if (blockSize - asize >= SPLIT_MIN)
+    {
+        PUT(HDRP(bp), PACK_BAND(asize, band, 1));
+        PUT(FTRP(bp), PACK_BAND(asize, band, 1));
+
+        char *next_bp = NEXT_BLKP(bp);
+        PUT(HDRP(next_bp), PACK_BAND(blockSize - asize, band, 0));
+        PUT(FTRP(next_bp), PACK_BAND(blockSize - asize, band, 0));
+        link_free(next_bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK_BAND(blockSize, band, 1));
+        PUT(FTRP(bp), PACK_BAND(blockSize, band, 1));
+    }
+}
+
+/// @brief 병합으로 heap->rover가 가리키던 블록이 사라졌으면 병합된 블록으로 옮기는 함수
+static inline void fix_rover(char *bp)
+{
+#if MM_PLACEMENT == MM_PLACE_NEXT
+    if (heap->rover > bp && heap->rover < NEXT_BLKP(bp))
+    {
+        heap->rover = bp;
+    }
+#endif
+}
+
+/// @note MM_PLACE_BINS에서는 이웃 빈 블록을 bin에서 빼고 합친 뒤, 합친 블록을 bin에 넣음
+static void* coalesce(char *bp)
+{
+    PREFETCH(HDRP(NEXT_BLKP(bp))); // 뒤 블록 헤더
+    PREFETCH(HDRP(PREV_BLKP(bp))); // 앞 블록 헤더 (앞 블록 푸터의 크기로 계산)
+
+    size_t band = GET_BAND(HDRP(bp));
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+
+#if MM_SPAN_SIZE
+    // 일반 블록은 band에 상관없이 이웃 빈 블록을 병합하고, 스팬 블록은 같은
+    // band끼리만 병합함
+    if (band != BAND_GENERAL)
+    {
+        prev_alloc = prev_alloc || GET_BAND(FTRP(PREV_BLKP(bp))) != band;
+        next_alloc = next_alloc || GET_BAND(HDRP(NEXT_BLKP(bp))) != band;
+    }
+#endif
+
+    if (prev_alloc && next_alloc) // 앞 뒤에 빈 블록이 없을 때
+    {
+        // 병합할 것 없음
+    }
+    else if (prev_alloc && !next_alloc) // 뒤에 블록만 비어있을 때
+    {
+        unlink_free(NEXT_BLKP(bp));
+        size += GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        PUT(HDRP(bp), PACK_BAND(size, band, 0));
+        PUT(FTRP(bp), PACK_BAND(size, band, 0));
+    }
+    else if (!prev_alloc && next_alloc) // 앞의 블록만 비어있을 때
+    {
+        unlink_free(PREV_BLKP(bp));
+        size += GET_SIZE(HDRP(PREV_BLKP(bp)));
+        PUT(HDRP(PREV_BLKP(bp)), PACK_BAND(size, band, 0));
+        PUT(FTRP(bp), PACK_BAND(size, band, 0));
+        bp = PREV_BLKP(bp);
+    }
+    else // 앞과 뒤 블록 다 비어있을 때
+    {
+        unlink_free(PREV_BLKP(bp));
+        unlink_free(NEXT_BLKP(bp));
+        size += GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        PUT(HDRP(PREV_BLKP(bp)), PACK_BAND(size, band, 0));
+        PUT(FTRP(NEXT_BLKP(bp)), PACK_BAND(size, band, 0));
+        bp = PREV_BLKP(bp);
+    }
+#if MM_SPAN_SIZE
+    // 스팬 하나만큼 비었거나, 일반 band의 빈 블록과 맞닿았는데 양옆에 같은 band의
+    // 할당 블록이 없으면 일반 band로. 그대로 두면 둘 다
+    // 비어도 병합되지 않아 힙 끝을 줄일 수 없음. 스팬에 살아 있는 블록이 남아
+    // 있으면 가장자리가 비어도 스팬은 그대로 둠
+    if (band != BAND_GENERAL)
+    {
+        char *prev_tag = FTRP(PREV_BLKP(bp));
+        char *next_tag = HDRP(NEXT_BLKP(bp));
+
+        if (size >= MM_SPAN_SIZE ||
+            (((!GET_ALLOC(prev_tag) && GET_BAND(prev_tag) == BAND_GENERAL) ||
+              (!GET_ALLOC(next_tag) && GET_BAND(next_tag) == BAND_GENERAL)) &&
+             !(GET_ALLOC(prev_tag) && GET_BAND(prev_tag) == band) &&
+             !(GET_ALLOC(next_tag) && GET_BAND(next_tag) == band)))
+        {
+            PUT(HDRP(bp), PACK(size, 0));
+            PUT(FTRP(bp), PACK(size, 0));
+            return coalesce(bp);
+        }
+    }
+    // 흡수한 스팬 블록 너머에 다른 빈 블록이 또 있으면 마저 병합
+    if (band == BAND_GENERAL &&
+        (!GET_ALLOC(FTRP(PREV_BLKP(bp))) || !GET_ALLOC(HDRP(NEXT_BLKP(bp)))))
+    {
+        return coalesce(bp);
+    }
+#endif
+    fix_cursor(bp);
+    link_free(bp);
+    return bp;
+}
+
+static void *extend_heap(size_t words)
+{
+    char *bp;
+    size_t size;
+
+    /* alignment 유지를 위해 짝수 개수의 words를 allocate */
+    size = ALIGN((words % 2) ? (words + 1) * WSIZE : words * WSIZE);
+
+    if ((long)(bp = mem_sbrk(size)) == -1)
+        return NULL;
+    SET_HEAP_END(bp + size);
+
+    /* 새 free 블록의 헤더/푸터, 그리고 새 에필로그 설정 */
+    PUT(HDRP(bp), PACK(size, 0));          /* Free block header   (bp는 payload 포인터로 취급) */
+    PUT(FTRP(bp), PACK(size, 0));          /* Free block footer */
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 1));  /* New epilogue header */
+
+    /* 직전 블록이 free였다면 병합 */
+    return coalesce(bp);
+}
+
+/// @brief 힙을 초기화 하는 함수
+/// @param  
+/// @return 성공 여부 : -1(fail) / 0(success)
+int mm_init(void)
+{
+    reset_handles();
+    HARDEN_INIT();
+    if ((heap->heap_listp = mem_sbrk(PROLOGUE_SIZE)) == (void *)-1)
+        return -1;
+    SET_HEAP_END(heap->heap_listp + PROLOGUE_SIZE);
+    heap->heap_listp += PROLOGUE_SIZE - 4 * WSIZE; // 남는 앞부분은 패딩
+
+    PUT(heap->heap_listp, 0); // 패딩
+    PUT(heap->heap_listp + WSIZE, PACK(DSIZE, 1)); // 프롤로그 헤더
+    PUT(heap->heap_listp + DSIZE, PACK(DSIZE, 1)); // 프롤로그 푸터
+    PUT(heap->heap_listp + 3*WSIZE, PACK(0, 1)); // 에필로그 헤더
+    heap->heap_listp += (2*WSIZE); // 프롤로그 payload 가리키도록 바꾸기
+#if MM_PLACEMENT == MM_PLACE_NEXT
+    heap->rover = heap->heap_listp;
+#elif MM_PLACEMENT == MM_PLACE_BINS
+    memset(heap->bin_map, 0, sizeof(heap->bin_map));
+    memset(heap->bins, 0, sizeof(heap->bins));
+#endif
+#if MM_NURSERY
+    // 점수도 지움: 앞 실행(다른 trace일 수도 있음)에서 배운 수명이 배치를 바꾸지 않도록
+    heap->lt_clock = 0;
+    memset(heap->lt_score, 0, sizeof(heap->lt_score));
+    memset(heap->lt_samples, 0, sizeof(heap->lt_samples));
+#endif
+    RESET_GROWTH();
+
+    if (extend_heap(CHUNKSIZE / WSIZE) == NULL) // 힙 확장 -> 4KB
+    {
+        return -1; // 힙 확장 실패
+    }
+
+    return 0; // 힙 확장 성공
+}
+
+#if MM_NURSERY
+/*
+ * 수명 예측: 블록 주소로 고른 표본 칸에 malloc 시각을 적어 두고, free될 때
+ * 같은 블록이 아직 칸에 있으면 그 사이의 malloc 횟수로 클래스 점수를 올리거나
+ * (MM_NURSERY_AGE 미만) 내린다. 칸을 다른 블록이 덮을 때 먼저 있던 블록이
+ * 이미 오래 살았으면 그것도 긴 수명으로 친다. 긴 수명은 2점을 깎아서
+ * 섞인 클래스는 nursery로 가지 않는다 (오래 사는 블록 하나가 스팬을 붙잡음).
+ * 점수는 mm_init마다 0에서 다시 배운다. 그래서 결과는 같은 힙에서 앞서 돌린
+ * 실행과 무관하고, 실행마다 처음 몇백 번의 malloc은 nursery 없이 배치된다.
+ */
+
+/// @brief 수명 클래스 (힌트가 있으면 힌트, 없으면 크기 bin)
+static inline int lt_class(size_t asize, unsigned int hint)
+{
+    return hint != MM_HINT_NONE ? BIN_COUNT + hint % BIN_COUNT : bin_index(asize);
+}
+
+/// @brief bp의 표본 칸
+static inline lt_sample_t *lt_slot(char *bp)
+{
+    return &heap->lt_samples[((uintptr_t)bp >> 4) & (LT_SAMPLES - 1)];
+}
+
+/// @brief 클래스 cls에 수명 한 번을 반영하는 함수
+static inline void lt_vote(int cls, unsigned int age)
+{
+    signed char *score = &heap->lt_score[cls];
+
+    if (age < MM_NURSERY_AGE)
+    {
+        *score += *score < LT_SCORE_MAX;
+    }
+    else
+    {
+        *score = *score - 2 < LT_SCORE_MIN ? LT_SCORE_MIN : *score - 2;
+    }
+}
+
+/// @brief 시각을 한 칸 올리고 새 블록 bp를 표본 칸에 적는 함수
+/// @note 스팬에 들어갈 수 없는 큰 블록은 적지 않음
+static inline void lt_birth(char *bp, size_t asize, int cls)
+{
+    lt_sample_t *s = lt_slot(bp);
+
+    heap->lt_clock++;
+    if (asize > MM_SPAN_SIZE / 8)
+    {
+        return;
+    }
+    if (s->bp != NULL && heap->lt_clock - s->birth >= MM_NURSERY_AGE)
+    {
+        lt_vote(s->cls, MM_NURSERY_AGE);
+    }
+    s->bp = bp;
+    s->birth = heap->lt_clock;
+    s->cls = cls;
+}
+
+/// @brief free되는 블록 bp가 표본 칸에 있으면 수명을 반영하는 함수
+static inline void lt_death(char *bp)
+{
+    lt_sample_t *s = lt_slot(bp);
+
+    if (s->bp == bp)
+    {
+        lt_vote(s->cls, heap->lt_clock - s->birth);
+        s->bp = NULL;
+    }
+}
+
+/// @brief realloc이 옮긴 블록 bp를 표본에서 빼는 함수
+/// @note 옮겨진 것은 블록이 죽은 게 아니므로 수명을 반영하지 않음
+static inline void lt_forget(char *bp)
+{
+    lt_sample_t *s = lt_slot(bp);
+
+    if (s->bp == bp)
+    {
+        s->bp = NULL;
+    }
+}
+#else
+#define lt_class(asize, hint) 0
+#define lt_birth(bp, asize, cls) ((void)(cls))
+#define lt_death(bp)
+#define lt_forget(bp)
+#endif
+
+#if MM_SPAN_SIZE
+/// @brief asize 블록이 갈 band를 고르는 함수
+/// @param cls 수명 클래스 (MM_NURSERY에서 짧게 산다고 배운 클래스는 nursery로)
+/// @note 스팬의 1/8보다 큰 블록은 힌트가 있어도 일반 band로
+static inline int pick_band(size_t asize, unsigned int hint, int cls)
+{
+    if (asize > MM_SPAN_SIZE / 8)
+    {
+        return BAND_GENERAL;
+    }
+#if MM_NURSERY
+    if (heap->lt_score[cls] > 0)
+    {
+        return BAND_NURSERY;
+    }
+#else
+    (void)cls;
+#endif
+    if (hint != MM_HINT_NONE)
+    {
+        return BAND_HINT + (hint - 1) % HINT_BANDS;
+    }
+    return asize <= MM_SPAN_SMALL ? BAND_SMALL : BAND_GENERAL;
+}
+
+/// @brief 일반 band에서 MM_SPAN_SIZE만큼 떼어 band의 빈 블록으로 만드는 함수
+/// @return 새 스팬 (bin에 들어있음) / 힙을 늘릴 수 없으면 NULL
+static char *add_span(int band)
+{
+    char *bp, *rest;
+    size_t size;
+
+    if ((bp = find_fit(MM_SPAN_SIZE, BAND_GENERAL)) == NULL &&
+        (bp = extend_heap(heap_growth(MM_SPAN_SIZE) / WSIZE)) == NULL)
+    {
+        return NULL;
+    }
+    unlink_free(bp);
+    size = GET_SIZE(HDRP(bp));
+    if (size - MM_SPAN_SIZE >= MIN_BLOCK) // 남는 뒷부분은 일반 band에 그대로
+    {
+        size = MM_SPAN_SIZE;
+        rest = bp + size;
+        PUT(HDRP(rest), PACK(GET_SIZE(HDRP(bp)) - size, 0));
+        PUT(FTRP(rest), PACK(GET_SIZE(HDRP(rest)), 0));
+        link_free(rest);
+    }
+    PUT(HDRP(bp), PACK_BAND(size, band, 0));
+    PUT(FTRP(bp), PACK_BAND(size, band, 0));
+    link_free(bp);
+    return bp;
+}
+#else
+#define pick_band(asize, hint, cls) ((void)(cls), BAND_GENERAL)
+#endif
+
+/// @brief malloc 함수
+/// @param size 할당 받을 크기
+/// @return 할당 받을 블록의 payload
+void *mm_malloc(size_t size)
+{
+    return mm_malloc_hint(size, MM_HINT_NONE);
+}
+
+/// @brief 배치 힌트가 있는 malloc 함수
+/// @param hint 같은 힌트의 블록끼리 스팬을 나눠 씀 (MM_HINT_NONE이면 크기로 band 결정)
+/// @return 할당 받을 블록의 payload
+void *mm_malloc_hint(size_t size, unsigned int hint)
+{
+    size_t reqsize; // 요구 받은 사이즈를 정렬한 사이즈
+    char *bp; // 리턴할 블록 payload의 포인터
+    int band, cls;
+
+    if (size == 0) // 요구 사이즈 = 0
+    {
+        return NULL;
+    }
+
+    reqsize = MAX(ALIGN(size + 2 * WSIZE), MIN_BLOCK); // 요구 사이즈를 정렬
+    // 헤더/푸터를 더해 ALIGNMENT의 배수로 올리고, 최소 블록(MIN_BLOCK)보다 작으면 최소 블록으로
+    reqsize = class_size(reqsize);
+    cls = lt_class(reqsize, hint);
+    band = pick_band(reqsize, hint, cls);
+    COUNT_MALLOC();
+
+    if ((bp = find_fit(reqsize, band)) == NULL) // 맞는 블록이 없으면 힙 확장
+    {
+#if MM_SPAN_SIZE
+        if (band != BAND_GENERAL)
+        {
+            bp = add_span(band); // 스팬은 reqsize보다 항상 큼
+        }
+        else
+#endif
+        bp = extend_heap(heap_growth(reqsize) / WSIZE);
+        if (bp == NULL)
+        {
+            return NULL;
+        }
+        fix_rover(bp);
+    }
+    place(bp, reqsize);
+    lt_birth(bp, reqsize, cls);
+
+    return bp;
+}
+
+void mm_free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    CHECK_BLOCK("mm_free", ptr);
+    size_t size = GET_SIZE(HDRP(ptr));
+    size_t band = GET_BAND(HDRP(ptr));
+    lt_death((char *)ptr);
+    PUT(HDRP(ptr), PACK_BAND(size, band, 0));
+    PUT(FTRP(ptr), PACK_BAND(size, band, 0));
+    fix_rover(coalesce((char *)ptr));
+}
+
+#if MM_REMAP_THRESHOLD > 0
+/// @brief 큰 블록을 새 블록으로 옮기는 realloc 경로: 통째로 든 페이지는 복사하지 않고
+///        mem_remap(mremap)으로 옮기고, 앞뒤 걸친 부분만 복사함
+/// @note 페이지를 옮기려면 새 payload가 ptr와 페이지 안에서 같은 위치여야 해서
+///       한 페이지(+최소 블록)만큼 큰 빈 블록을 얻고 앞을 잘라 빈 블록으로 남김
+static void *realloc_remap(char *ptr, size_t asize, size_t copySize)
+{
+    size_t pg = mem_pagesize();
+    size_t need = asize + pg + MIN_BLOCK;
+    size_t blockSize, shift;
+    char *bp;
+
+    COUNT_MALLOC();
+    if ((bp = find_fit(need, BAND_GENERAL)) == NULL)
+    {
+        if ((bp = extend_heap(heap_growth(need) / WSIZE)) == NULL)
+        {
+            return NULL;
+        }
+        fix_rover(bp);
+    }
+
+    blockSize = GET_SIZE(HDRP(bp));
+    shift = ((uintptr_t)ptr - (uintptr_t)bp) & (pg - 1);
+    if (shift != 0 && shift < MIN_BLOCK) // 앞 조각이 최소 블록보다 작으면 한 페이지 더 밀기
+    {
+        shift += pg;
+    }
+    if (shift != 0)
+    {
+        unlink_free(bp);
+        PUT(HDRP(bp), PACK(shift, 0));
+        PUT(FTRP(bp), PACK(shift, 0));
+        link_free(bp);
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(blockSize - shift, 0));
+        PUT(FTRP(bp), PACK(blockSize - shift, 0));
+        link_free(bp);
+    }
+    place(bp, asize);
+    // 뒤에 남은 조각이 힙 끝이면 돌려줌: 남겨 두면 bins 정책이 작은 블록을 거기
+    // 놓아서, 다음에 이 블록이 커질 때 힙 끝 경로 대신 또 옮기게 됨
+    if (!GET_ALLOC(HDRP(NEXT_BLKP(bp))) && GET_SIZE(HDRP(NEXT_BLKP(NEXT_BLKP(bp)))) == 0)
+    {
+        mm_trim();
+    }
+
+    mem_remap(bp, ptr, copySize, block_copy);
+    lt_forget(ptr);
+    mm_free(ptr);
+    return bp;
+}
+#endif
+
+/// @brief realloc 함수: 줄이거나, 뒤 빈 블록을 흡수하거나, 힙 끝이면 모자란 만큼
+///        힙을 늘려서 제자리에서 처리하고, 안 되면 새 블록으로 옮김
+void *mm_realloc(void *ptr, size_t size)
+{
+    size_t asize, oldSize, total, band;
+    char *next;
+
+    if (ptr == NULL)
+    {
+        return mm_malloc(size);
+    }
+
+    if (size == 0)
+    {
+        mm_free(ptr);
+        return NULL; 
+    }
+
+    CHECK_BLOCK("mm_realloc", ptr);
+    asize = class_size(MAX(ALIGN(size + 2 * WSIZE), MIN_BLOCK));
+    oldSize = GET_SIZE(HDRP(ptr));
+    band = GET_BAND(HDRP(ptr));
+    next = NEXT_BLKP(ptr);
+    total = oldSize + ((GET_ALLOC(HDRP(next)) || GET_BAND(HDRP(next)) != band) ? 0 : GET_SIZE(HDRP(next)));
+
+    // 힙 끝 블록이면 (뒤가 에필로그이거나 마지막 빈 블록) 모자란 만큼만 확장
+    // (확장분은 일반 band라 일반 블록만)
+    if (total < asize && band == BAND_GENERAL &&
+        (GET_SIZE(HDRP(next)) == 0 ||
+         (!GET_ALLOC(HDRP(next)) && GET_BAND(HDRP(next)) == band && GET_SIZE(HDRP(NEXT_BLKP(next))) == 0)))
+    {
+        // 확장분도 잠깐 빈 블록이 되므로 최소 블록보다 작게 늘리지 않음
+        if (extend_heap(MAX(asize - total, MIN_BLOCK) / WSIZE) == NULL)
+        {
+            return NULL;
+        }
+        next = NEXT_BLKP(ptr); // 확장분은 뒤 빈 블록과 병합됨
+        total = oldSize + GET_SIZE(HDRP(next));
+    }
+
+    if (total >= asize)
+    {
+        if (total > oldSize)
+        {
+            unlink_free(next);
+        }
+        PUT(HDRP(ptr), PACK_BAND(total, band, 1));
+        PUT(FTRP(ptr), PACK_BAND(total, band, 1));
+        fix_rover(ptr); // 흡수한 빈 블록을 heap->rover가 가리키고 있었을 수 있음
+        fix_cursor(ptr);
+        if (total - asize >= SPLIT_MIN)
+        {
+            PUT(HDRP(ptr), PACK_BAND(asize, band, 1));
+            PUT(FTRP(ptr), PACK_BAND(asize, band, 1));
+            next = NEXT_BLKP(ptr);
+            PUT(HDRP(next), PACK_BAND(total - asize, band, 0));
+            PUT(FTRP(next), PACK_BAND(total - asize, band, 0));
+            fix_rover(coalesce(next)); // 줄인 경우 남은 부분 뒤가 빈 블록일 수 있음
+        }
+        return ptr;
+    }
+
+#if MM_REMAP_THRESHOLD > 0
+    if (MIN(oldSize - DSIZE, size) >= MM_REMAP_THRESHOLD)
+    {
+        return realloc_remap(ptr, asize, MIN(oldSize - DSIZE, size));
+    }
+#endif
+
+    void *newptr = mm_malloc(size);
+    if (newptr == NULL)
+    {
+        return NULL;
+    }
+    block_copy(newptr, ptr, MIN(oldSize - DSIZE, size));
+    lt_forget(ptr);
+    mm_free(ptr);
+    return newptr;
+}
+
+#endif /* MM_REALTIME */
+
+/// @brief 힙의 모든 블록을 주소 순서대로 방문하는 함수 (힙 스냅샷용)
+/// @param visit 블록마다 호출할 함수 (payload 포인터, 블록 크기, 할당 여부, arg)
+/// @param arg visit에 그대로 넘겨줄 인자
+void mm_walk(mm_visit_t visit, void *arg)
+{
+    char *bp;
+
+    for (bp = NEXT_BLKP(heap->heap_listp); GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        visit(bp, GET_SIZE(HDRP(bp)), GET_ALLOC(HDRP(bp)), arg);
+    }
+}
+
+/// @brief 빈 블록 bp를 빈 블록 인덱스에서 빼는 함수 (블록을 없애거나 덮어쓰기 전에)
+/// @note next fit은 rover가 bp나 그 근처의 옮겨질 블록을 가리킬 수 있어서 처음으로 돌림
+static void take_free(char *bp)
+{
+#ifdef MM_REALTIME
+    remove_free(bp);
+#elif MM_PLACEMENT == MM_PLACE_NEXT
+    (void)bp;
+    heap->rover = heap->heap_listp;
+#elif MM_PLACEMENT == MM_PLACE_BINS
+    unlink_free(bp);
+#else
+    (void)bp;
+#endif
+}
+
+/// @brief 힙 끝의 빈 블록을 mem_sbrk로 반납하는 함수
+/// @return 반납한 바이트 수 (마지막 블록이 할당 중이면 0)
+size_t mm_trim(void)
+{
+    char *bp = (char *)mem_heap_hi() + 1; // 에필로그 바로 뒤 (= 에필로그 블록의 bp)
+    size_t size;
+
+    bp = PREV_BLKP(bp);
+    if (bp == heap->heap_listp || GET_ALLOC(HDRP(bp)))
+    {
+        return 0;
+    }
+
+    take_free(bp);
+    size = GET_SIZE(HDRP(bp));
+    if ((long)mem_sbrk(-(int)size) == -1)
+    {
+        return 0;
+    }
+    SET_HEAP_END(bp);
+    PUT(HDRP(bp), PACK(0, 1)); // 빈 블록 헤더 자리가 새 에필로그 헤더
+    return size;
+}
+
+/*
+ * 핸들 블록: payload 앞 SIZE_T_SIZE 바이트에 자기 핸들 번호를 두고, 핸들
+ * 테이블의 그 칸이 블록을 가리킨다. 그래서 할당 블록이 핸들 블록인지는
+ * 번호를 읽어 테이블이 그 블록을 가리키는지로 알 수 있다 (다른 블록은 어떤
+ * 값이 들어 있어도 테이블이 가리키지 않음).
+ *
+ * mm_compact는 커서부터 블록을 차례로 보면서 빈 블록 바로 뒤의 핸들 블록을
+ * 빈 블록 자리로 당기고 (memmove), 밀려난 빈 블록은 뒤의 빈 블록과 병합해서
+ * 계속 뒤로 보낸다. 일반 블록은 옮길 수 없어서 그 앞의 빈 블록은 남는다.
+ * 힙 끝까지 가면 끝의 빈 블록을 mm_trim으로 memlib에 돌려준다.
+ *
+ * 블록마다 시계를 보고, 지금까지 잰 속도(compact_rate)로 추정한 복사 시간이
+ * 남은 시간을 넘으면 그 블록은 다음 호출로 미룬다. 호출 하나의 예산 전체로도
+ * 모자라는 블록(호출의 첫 블록인데도 남은 시간을 넘는 블록)은 미루면 영영 못
+ * 지나가므로 payload를 조금씩 나눠서 여러 호출에 걸쳐 옮긴다 (move_*). 그동안
+ * 빈 블록과 핸들 블록은 둘을 합친 크기의 할당 블록 하나로 보이게 해서, 힙을
+ * 도는 코드와 이웃 블록의 병합이 복사 중인 자리를 건드리지 않게 한다. 옮기는
+ * 중인 핸들을 mm_hderef/mm_hrealloc/mm_hfree로 쓰면 남은 복사를 그 자리에서
+ * 끝낸다. 힙 끝에 닿았을 때 시간이 다 됐으면 mm_trim도 다음 호출로 미룬다.
+ */
+
+/** @brief 나눠 옮길 때 한 번에 복사하는 가장 작은 양 (바이트, 호출마다 조금은 나아가도록) */
+#define COMPACT_CHUNK_MIN 256
+
+/** @brief 핸들 테이블의 처음 크기 */
+#define HANDLE_MIN 64
+
+/// @brief 할당 블록 bp가 핸들 블록이면 그 핸들, 아니면 MM_HANDLE_NONE
+static mm_handle_t handle_of(char *bp)
+{
+    size_t h = *(size_t *)bp;
+
+    if (h > 0 && h < heap->handle_count && heap->handles[h] == (uintptr_t)bp)
+    {
+        return h;
+    }
+    return MM_HANDLE_NONE;
+}
+
+/// @brief 옮길 수 있는 블록을 할당하는 함수
+/// @return 핸들 / 할당할 수 없으면 MM_HANDLE_NONE
+mm_handle_t mm_halloc(size_t size)
+{
+    uintptr_t *table;
+    size_t h, cap;
+    char *bp;
+
+    if (heap->handle_free == 0 && heap->handle_count == heap->handle_cap)
+    {
+        cap = heap->handle_cap ? 2 * heap->handle_cap : HANDLE_MIN;
+        if ((table = realloc(heap->handles, cap * sizeof(uintptr_t))) == NULL)
+        {
+            return MM_HANDLE_NONE;
+        }
+        heap->handles = table;
+        heap->handle_cap = cap;
+        heap->handle_count = MAX(heap->handle_count, 1);
+    }
+    if ((bp = mm_malloc(size + SIZE_T_SIZE)) == NULL)
+    {
+        return MM_HANDLE_NONE;
+    }
+
+    if (heap->handle_free != 0)
+    {
+        h = heap->handle_free;
+        heap->handle_free = heap->handles[h] >> 1;
+    }
+    else
+    {
+        h = heap->handle_count++;
+    }
+    heap->handles[h] = (uintptr_t)bp;
+    *(size_t *)bp = h;
+    return h;
+}
+
+/// @brief 나눠 옮기던 블록의 남은 payload를 복사하고 핸들 블록과 뒤의 빈 블록을 제자리에 두는 함수
+/// @return 핸들 블록 뒤에 남은 빈 블록 (병합된 뒤의 bp)
+static char *move_finish(void)
+{
+    char *bp = heap->move_bp;
+    size_t gap = heap->move_gap;
+    size_t size = GET_SIZE(HDRP(bp)) - gap;
+    size_t band = GET_BAND(HDRP(bp));
+
+    memmove(bp + heap->move_done, bp + gap + heap->move_done, size - DSIZE - heap->move_done);
+    PUT(HDRP(bp), PACK_BAND(size, band, 1));
+    PUT(FTRP(bp), PACK_BAND(size, band, 1));
+    heap->handles[heap->move_handle] = (uintptr_t)bp;
+    heap->move_bp = NULL;
+
+    bp += size;
+    PUT(HDRP(bp), PACK_BAND(gap, band, 0));
+    PUT(FTRP(bp), PACK_BAND(gap, band, 0));
+#ifdef MM_REALTIME
+    bp = coalesce(bp);
+    insert_free(bp);
+#else
+    bp = coalesce(bp);
+    fix_rover(bp);
+#endif
+    return bp;
+}
+
+/// @brief 빈 블록 bp 자리로 바로 뒤의 핸들 블록 h를 옮기기 시작하는 함수
+/// @note 다 옮길 때까지 두 블록을 합친 할당 블록 하나로 보이게 함. 핸들 블록의
+///       푸터는 복사 범위 밖이라 뒤 블록의 병합도 이 블록을 할당된 것으로 봄
+static void move_begin(char *bp, mm_handle_t h)
+{
+    size_t gap = GET_SIZE(HDRP(bp));
+    size_t total = gap + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+    size_t band = GET_BAND(HDRP(bp));
+
+    take_free(bp);
+    PUT(HDRP(bp), PACK_BAND(total, band, 1));
+    PUT(FTRP(bp), PACK_BAND(total, band, 1));
+    heap->move_bp = bp;
+    heap->move_gap = gap;
+    heap->move_done = 0;
+    heap->move_handle = h;
+    heap->compact_cursor = NULL;
+}
+
+/// @brief 옮기는 중인 블록을 deadline까지 복사하는 함수 (deadline이 0이면 끝까지)
+/// @return 다 옮겼으면 뒤에 남은 빈 블록, 아직이면 NULL
+static char *move_step(long long deadline)
+{
+    char *bp = heap->move_bp;
+    size_t left = GET_SIZE(HDRP(bp)) - heap->move_gap - DSIZE - heap->move_done;
+    size_t n = left;
+    long long t = 0, cost;
+
+    if (deadline)
+    {
+        t = now_ns();
+        cost = MAX(deadline - t, 0) * 1000 / heap->compact_rate;
+        if ((size_t)cost < n)
+        {
+            n = MIN(MAX((size_t)cost, COMPACT_CHUNK_MIN), n);
+        }
+    }
+    memmove(bp + heap->move_done, bp + heap->move_gap + heap->move_done, n);
+    heap->move_done += n;
+
+    // 큰 조각에서 잰 속도만 반영 (작은 조각은 복사보다 고정 비용이 커서 속도를 부풀림)
+    if (deadline && n >= COMPACT_RATE_MIN)
+    {
+        cost = (now_ns() - t) * 1000 / (long long)n;
+        heap->compact_rate = (3 * heap->compact_rate + (unsigned int)MIN(cost, COMPACT_RATE_MAX)) / 4;
+    }
+    return n < left ? NULL : move_finish();
+}
+
+/// @brief 핸들 h의 블록을 옮기는 중이면 남은 복사를 끝내는 함수 (압축은 그 뒤부터 이어감)
+static void move_settle(mm_handle_t h)
+{
+    if (heap->move_bp != NULL && heap->move_handle == h)
+    {
+        heap->compact_cursor = move_finish();
+    }
+}
+
+/// @brief 핸들 h의 블록 주소 (다음 mm_compact/mm_hrealloc까지만 유효)
+void *mm_hderef(mm_handle_t h)
+{
+    move_settle(h);
+    return (char *)heap->handles[h] + SIZE_T_SIZE;
+}
+
+/// @brief 핸들 h의 블록 크기를 바꾸는 함수 (핸들은 그대로)
+/// @return 새 블록 주소 / 실패하면 NULL (원래 블록은 그대로)
+void *mm_hrealloc(mm_handle_t h, size_t size)
+{
+    char *bp;
+
+    move_settle(h);
+    bp = mm_realloc((char *)heap->handles[h], size + SIZE_T_SIZE);
+    if (bp == NULL)
+    {
+        return NULL;
+    }
+    heap->handles[h] = (uintptr_t)bp; // 핸들 번호는 realloc이 같이 옮김
+    return bp + SIZE_T_SIZE;
+}
+
+/// @brief 핸들 h의 블록을 해제하는 함수
+void mm_hfree(mm_handle_t h)
+{
+    if (h == MM_HANDLE_NONE)
+    {
+        return;
+    }
+    move_settle(h);
+    mm_free((char *)heap->handles[h]);
+    heap->handles[h] = (heap->handle_free << 1) | 1;
+    heap->handle_free = h;
+}
+
+/// @brief 핸들 블록을 빈 블록 쪽으로 당겨 모으는 압축을 budget_ns 동안 하는 함수
+/// @param budget_ns 이번 호출에 쓸 시간 (나노초, 0 이하면 끝까지)
+/// @return 힙 끝까지 가서 끝의 빈 공간을 반납했으면 1, 시간이 다 돼서 멈췄으면 0
+///         (다음 호출은 멈춘 곳부터)
+int mm_compact(long budget_ns)
+{
+    long long deadline = budget_ns > 0 ? now_ns() + budget_ns : 0;
+    char *bp, *start, *next;
+    size_t size;
+    mm_handle_t h;
+    long long t = 0;
+
+    // 지난 호출에서 나눠 옮기던 블록이 있으면 그것부터
+    if (heap->move_bp != NULL)
+    {
+        if ((bp = move_step(deadline)) == NULL)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        bp = heap->compact_cursor ? heap->compact_cursor : NEXT_BLKP(heap->heap_listp);
+    }
+    start = bp;
+
+    while (!heap->compact_trim && GET_SIZE(HDRP(bp)) > 0)
+    {
+        if (deadline && (t = now_ns()) >= deadline)
+        {
+            heap->compact_cursor = bp;
+            return 0;
+        }
+        // 빈 블록 바로 뒤의 같은 band 핸들 블록만 옮김. 힙 끝 블록이 앞의 빈 블록보다
+        // 크면 그대로 둠 (작은 틈을 얻으려고 크게 복사하고, realloc으로 제자리에서
+        // 자랄 수 없게 됨)
+        next = NEXT_BLKP(bp);
+        if (GET_ALLOC(HDRP(bp)) || !GET_ALLOC(HDRP(next)) || GET_SIZE(HDRP(next)) == 0 ||
+            (GET_SIZE(HDRP(NEXT_BLKP(next))) == 0 && GET_SIZE(HDRP(next)) > GET_SIZE(HDRP(bp))) ||
+            GET_BAND(HDRP(next)) != GET_BAND(HDRP(bp)) || (h = handle_of(next)) == MM_HANDLE_NONE)
+        {
+            bp = next;
+            continue;
+        }
+
+        // 남은 시간 안에 못 옮길 블록은 다음 호출로 미룸. 호출의 첫 블록이면 남은 시간만큼
+        // 옮기고 나머지는 다음 호출에서 이어 옮김
+        size = GET_SIZE(HDRP(next));
+        if (deadline && bp != start && t + (long long)size * heap->compact_rate / 1000 > deadline)
+        {
+            heap->compact_cursor = bp;
+            return 0;
+        }
+        move_begin(bp, h);
+        if ((bp = move_step(deadline)) == NULL)
+        {
+            return 0;
+        }
+    }
+
+    // 힙 끝. 반납은 시간이 남았을 때만 (아니면 다음 호출이 바로 반납)
+    heap->compact_cursor = NULL;
+    if (deadline && !heap->compact_trim && now_ns() >= deadline)
+    {
+        heap->compact_trim = 1;
+        return 0;
+    }
+    heap->compact_trim = 0;
+    mm_trim();
+    return 1;
+}
+
+/// @brief h를 동작 중인 힙으로 바꾸고(memlib 영역도 함께) 원래 힙을 돌려주는 함수
+static mm_heap_t *heap_enter(mm_heap_t *h)
+{
+    mm_heap_t *prev = heap;
+
+    heap = h;
+#if MM_HARDEN
+    heap_key = h->secret;
+#endif
+    mem_region_use(h->region);
+    return prev;
+}
+
+/// @brief heap_enter 전의 힙으로 되돌리는 함수
+static void heap_leave(mm_heap_t *prev)
+{
+    heap = prev;
+#if MM_HARDEN
+    heap_key = prev->secret;
+#endif
+    mem_region_use(prev->region);
+}
+
+/// @brief 자기 memlib 영역을 가진 새 힙을 만드는 함수
+/// @param max 힙이 커질 수 있는 최대 바이트 수
+/// @return 새 힙 (영역을 못 만들면 NULL)
+mm_heap_t *mm_heap_create(size_t max)
+{
+    mm_heap_t *h, *prev;
+    int rc;
+
+#if MM_COMPACT_LINKS
+    if (max > UINT32_MAX) // 32비트 오프셋 링크가 닿지 않는 크기
+    {
+        return NULL;
+    }
+#endif
+    if ((h = calloc(1, sizeof(mm_heap_t))) == NULL)
+    {
+        return NULL;
+    }
+    if ((h->region = mem_region_create(max)) == NULL)
+    {
+        free(h);
+        return NULL;
+    }
+
+    prev = heap_enter(h);
+    rc = mm_init();
+    heap_leave(prev);
+    if (rc < 0)
+    {
+        mm_heap_destroy(h);
+        return NULL;
+    }
+    return h;
+}
+
+/// @brief 힙 h에서 size 바이트를 할당하는 함수
+void *mm_heap_malloc(mm_heap_t *h, size_t size)
+{
+    mm_heap_t *prev = heap_enter(h);
+    void *bp = mm_malloc(size);
+
+    heap_leave(prev);
+    return bp;
+}
+
+/// @brief 힙 h의 블록 ptr을 해제하는 함수
+void mm_heap_free(mm_heap_t *h, void *ptr)
+{
+    mm_heap_t *prev = heap_enter(h);
+
+    mm_free(ptr);
+    heap_leave(prev);
+}
+
+/// @brief 힙 h의 블록 ptr의 크기를 바꾸는 함수 (옮겨도 같은 힙 안에서)
+void *mm_heap_realloc(mm_heap_t *h, void *ptr, size_t size)
+{
+    mm_heap_t *prev = heap_enter(h);
+    void *bp = mm_realloc(ptr, size);
+
+    heap_leave(prev);
+    return bp;
+}
+
+/// @brief 힙 h를 블록 하나하나 해제하지 않고 영역째 통째로 버리는 함수
+void mm_heap_destroy(mm_heap_t *h)
+{
+    mem_region_destroy(h->region);
+    free(h->handles);
+    free(h);
+}
@@ -5,6 +5,55 @@ extern void *mm_malloc (size_t size);
 extern void mm_free (void *ptr);
 extern void *mm_realloc(void *ptr, size_t size);
 
+/*
+ * mm_walk calls visit on every block of the heap, in address order,
+ * with the block pointer, its size in bytes and whether it is allocated.
+ */
+typedef void (*mm_visit_t)(void *bp, size_t size, int alloc, void *arg);
+extern void mm_walk(mm_visit_t visit, void *arg);
+
+/* mm_trim gives a free block at the end of the heap back to memlib */
+extern size_t mm_trim(void);
+
+/*
+ * mm_malloc_hint is mm_malloc with a placement hint. With spans
+ * enabled (MM_SPAN_SIZE), blocks with the same nonzero hint, e.g. an
+ * allocation site or objects that die together, share spans apart
+ * from other blocks. MM_HINT_NONE places by size like mm_malloc.
+ */
+#define MM_HINT_NONE 0
+extern void *mm_malloc_hint(size_t size, unsigned int hint);
+
+/*
+ * Relocatable blocks. mm_halloc returns a handle instead of a pointer,
+ * and mm_compact may slide handle blocks down over the free gaps in
+ * front of them and give the freed tail of the heap back to memlib.
+ * It stops once budget_ns nanoseconds have passed (<= 0: no limit)
+ * and returns 0; the next call continues from there. It returns 1
+ * once it has reached the end of the heap. A block too big to move
+ * within one budget is moved over several calls. A pointer from
+ * mm_hderef is only valid until the next mm_compact or mm_hrealloc.
+ */
+typedef size_t mm_handle_t;
+#define MM_HANDLE_NONE 0
+extern mm_handle_t mm_halloc(size_t size);
+extern void *mm_hderef(mm_handle_t h);
+extern void *mm_hrealloc(mm_handle_t h, size_t size);
+extern void mm_hfree(mm_handle_t h);
+extern int mm_compact(long budget_ns);
+
+/*
+ * Independent heaps. Each one lives in its own memlib region of at
+ * most max bytes, so mm_heap_destroy frees all of its blocks at once.
+ * The functions above work on the default heap.
+ */
+typedef struct mm_heap mm_heap_t;
+extern mm_heap_t *mm_heap_create(size_t max);
+extern void *mm_heap_malloc(mm_heap_t *h, size_t size);
+extern void mm_heap_free(mm_heap_t *h, void *ptr);
+extern void *mm_heap_realloc(mm_heap_t *h, void *ptr, size_t size);
+extern void mm_heap_destroy(mm_heap_t *h);
+
 
 /* 
  * Students work in teams of one or two.  Teams enter their team name, 
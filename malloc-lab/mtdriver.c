@@ -0,0 +1,455 @@
+/*
+ * mtdriver.c - Multithreaded trace replay driver
+ *
+ * Replays a trace with several threads at once to show how a malloc
+ * package scales. The requests of a trace are split into one stream
+ * per thread, either by the thread tags in the trace ("t <tid>"
+ * lines, see traces/README) or, for untagged traces, by partitioning
+ * the request ids round-robin over the threads. Each thread replays
+ * its stream in trace order.
+ *
+ * When a block is freed (or realloc'ed) by a different thread than
+ * the one that last touched it, the two threads hand the block off
+ * through a per-id slot: the later request waits until every earlier
+ * request on that id has completed, then picks up the pointer. Since
+ * a request only ever waits for requests that come before it in the
+ * trace, the replay can't deadlock.
+ *
+ * For 1..N threads we report the aggregate throughput and speedup of
+ * mm malloc and of libc malloc, and with -v the throughput of every
+ * thread. mm.c is not thread-safe, so by default its calls are
+ * serialized by one lock; use -u once it is.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "config.h"
+#include "trace.h"
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXLINE 1024	/* max string size */
+#define MAXTHREADS 64	/* max number of replay threads */
+#define DEFAULT_THREADS 4 /* default max number of replay threads (-n) */
+#define DEFAULT_RUNS 3	/* timed runs per configuration, best is kept (-r) */
+
+/******************************
+ * The key compound data types
+ *****************************/
+
+/*
+ * Handoff slot for one request id: the current block and how many
+ * requests on the id have completed. Padded to a cache line so that
+ * threads working on neighboring ids don't share lines.
+ */
+typedef struct
+{
+	char *ptr;		   /* current block of this id */
+	int done;		   /* requests on this id completed so far */
+	int tid;		   /* thread that completed the last one */
+	char pad[64 - sizeof(char *) - 2 * sizeof(int)];
+} slot_t;
+
+/* The malloc package being replayed */
+typedef struct
+{
+	char *name;
+	void *(*malloc)(size_t size);
+	void (*free)(void *ptr);
+	void *(*realloc)(void *ptr, size_t size);
+	void (*reset)(void);
+} allocator_t;
+
+/* One replay thread and its share of the trace */
+typedef struct
+{
+	pthread_t thread;
+	int id;		  /* thread number, 0..nthreads-1 */
+	int num_ops;  /* number of requests in this thread's stream */
+	int *opnums;  /* the requests, as indices into trace->ops */
+	int handoffs; /* requests on blocks last touched by another thread */
+	double start; /* when this thread started replaying its stream */
+	double end;	  /* when it was done */
+} worker_t;
+
+/* The result of replaying a trace with some number of threads */
+typedef struct
+{
+	double secs;				 /* wall clock time of the best run */
+	double kops[MAXTHREADS];	 /* per-thread Kops/sec of that run */
+	int handoffs;				 /* cross-thread requests */
+} mtstats_t;
+
+/********************
+ * Global variables
+ *******************/
+static int verbose = 0;	  /* global flag for verbose output */
+static int unlocked = 0;  /* call mm.c without the lock (-u) */
+
+/* Directory where default tracefiles are found */
+static char tracedir[MAXLINE] = TRACEDIR;
+
+/* The filenames of the default tracefiles */
+static char *default_tracefiles[] = {
+	DEFAULT_TRACEFILES, NULL};
+
+/* State shared by the replay threads of one run */
+static trace_t *trace;
+static slot_t *slots;
+static allocator_t *alloc;
+static pthread_barrier_t start_barrier;
+static pthread_mutex_t mm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*********************
+ * Function prototypes
+ *********************/
+static void replay_trace(int nthreads, int by_tag, int runs, mtstats_t *stats);
+static void *replay(void *arg);
+static void usage(void);
+
+/*******************************************
+ * mm.c and libc wrapped as allocator_t's.
+ * mm.c calls are serialized unless -u.
+ ******************************************/
+
+static void *mm_locked_malloc(size_t size)
+{
+	void *p;
+
+	if (unlocked)
+		return mm_malloc(size);
+	pthread_mutex_lock(&mm_lock);
+	p = mm_malloc(size);
+	pthread_mutex_unlock(&mm_lock);
+	return p;
+}
+
+static void mm_locked_free(void *ptr)
+{
+	if (unlocked)
+	{
+		mm_free(ptr);
+		return;
+	}
+	pthread_mutex_lock(&mm_lock);
+	mm_free(ptr);
+	pthread_mutex_unlock(&mm_lock);
+}
+
+static void *mm_locked_realloc(void *ptr, size_t size)
+{
+	void *p;
+
+	if (unlocked)
+		return mm_realloc(ptr, size);
+	pthread_mutex_lock(&mm_lock);
+	p = mm_realloc(ptr, size);
+	pthread_mutex_unlock(&mm_lock);
+	return p;
+}
+
+static void mm_reset(void)
+{
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in mm_reset");
+}
+
+static void libc_reset(void)
+{
+}
+
+static allocator_t allocators[] = {
+	{"mm", mm_locked_malloc, mm_locked_free, mm_locked_realloc, mm_reset},
+	{"libc", malloc, free, realloc, libc_reset}};
+
+#define NUM_ALLOCATORS (sizeof(allocators) / sizeof(allocator_t))
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+	int i, t, a, c;
+	char **tracefiles = NULL;	 /* null-terminated array of trace file names */
+	int num_tracefiles = 0;		 /* the number of traces in that array */
+	int max_threads = DEFAULT_THREADS; /* replay with 1..max_threads threads */
+	int runs = DEFAULT_RUNS;	 /* timed runs per configuration */
+	int mode = -1;				 /* 1: split by tag, 0: by id, -1: pick */
+	int by_tag;
+	mtstats_t stats[NUM_ALLOCATORS][MAXTHREADS + 1];
+
+	while ((c = getopt(argc, argv, "f:t:n:m:r:uvh")) != EOF)
+	{
+		switch (c)
+		{
+		case 'f': /* Use one specific trace file only (relative to curr dir) */
+			num_tracefiles = 1;
+			if ((tracefiles = realloc(tracefiles, 2 * sizeof(char *))) == NULL)
+				unix_error("ERROR: realloc failed in main");
+			strcpy(tracedir, "./");
+			tracefiles[0] = strdup(optarg);
+			tracefiles[1] = NULL;
+			break;
+		case 't': /* Directory where the traces are located */
+			if (num_tracefiles == 1) /* ignore if -f already encountered */
+				break;
+			strcpy(tracedir, optarg);
+			if (tracedir[strlen(tracedir) - 1] != '/')
+				strcat(tracedir, "/"); /* path always ends with "/" */
+			break;
+		case 'n': /* Max number of replay threads */
+			max_threads = atoi(optarg);
+			if (max_threads < 1 || max_threads > MAXTHREADS)
+				app_error("-n must be between 1 and 64");
+			break;
+		case 'm': /* How to split the trace into per-thread streams */
+			if (!strcmp(optarg, "tag"))
+				mode = 1;
+			else if (!strcmp(optarg, "id"))
+				mode = 0;
+			else
+				app_error("-m must be \"tag\" or \"id\"");
+			break;
+		case 'r': /* Timed runs per configuration */
+			if ((runs = atoi(optarg)) < 1)
+				app_error("-r must be at least 1");
+			break;
+		case 'u': /* mm.c is thread-safe, don't lock around it */
+			unlocked = 1;
+			break;
+		case 'v': /* Print per-thread throughput */
+			verbose = 1;
+			break;
+		case 'h': /* Print this message */
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	if (tracefiles == NULL)
+	{
+		tracefiles = default_tracefiles;
+		num_tracefiles = sizeof(default_tracefiles) / sizeof(char *) - 1;
+		printf("Using default tracefiles in %s\n", tracedir);
+	}
+
+	/* Initialize the simulated memory system in memlib.c */
+	mem_init();
+
+	for (i = 0; i < num_tracefiles; i++)
+	{
+		trace = read_trace(tracedir, tracefiles[i]);
+		by_tag = (mode < 0) ? (trace->num_tids > 1) : mode;
+		if ((slots = calloc(trace->num_ids, sizeof(slot_t))) == NULL)
+			unix_error("calloc failed in main");
+
+		printf("\n%s: %d ops, %d thread tags, split by %s\n",
+			   tracefiles[i], trace->num_ops, trace->num_tids,
+			   by_tag ? "tag" : "id");
+		for (a = 0; a < NUM_ALLOCATORS; a++)
+		{
+			alloc = &allocators[a];
+			for (t = 1; t <= max_threads; t++)
+				replay_trace(t, by_tag, runs, &stats[a][t]);
+		}
+
+		/* Print the scaling curve of both packages */
+		printf("%7s%10s%9s%10s%9s%10s\n", "threads", "mm Kops", "speedup",
+			   "libc Kops", "speedup", "handoffs");
+		for (t = 1; t <= max_threads; t++)
+		{
+			printf("%7d", t);
+			for (a = 0; a < NUM_ALLOCATORS; a++)
+				printf("%10.0f%8.2fx",
+					   trace->num_ops / 1e3 / stats[a][t].secs,
+					   stats[a][1].secs / stats[a][t].secs);
+			printf("%10d\n", stats[0][t].handoffs);
+		}
+
+		/* Optionally print the throughput of each thread */
+		if (verbose)
+		{
+			for (a = 0; a < NUM_ALLOCATORS; a++)
+				for (t = 2; t <= max_threads; t++)
+				{
+					int w;
+					printf("%6s %2d threads, per-thread Kops:",
+						   allocators[a].name, t);
+					for (w = 0; w < t; w++)
+						printf(" %.0f", stats[a][t].kops[w]);
+					printf("\n");
+				}
+		}
+
+		free(slots);
+		free_trace(trace);
+	}
+
+	mem_deinit();
+	exit(0);
+}
+
+/*
+ * replay_trace - Replay the trace with nthreads threads runs times
+ *     using the current allocator, and keep the fastest run.
+ */
+static void replay_trace(int nthreads, int by_tag, int runs, mtstats_t *stats)
+{
+	worker_t workers[MAXTHREADS];
+	int i, r, w;
+	double start, end, secs;
+
+	/* Split the trace into one stream per thread */
+	for (w = 0; w < nthreads; w++)
+	{
+		workers[w].id = w;
+		workers[w].num_ops = 0;
+		if ((workers[w].opnums = malloc(trace->num_ops * sizeof(int))) == NULL)
+			unix_error("malloc failed in replay_trace");
+	}
+	for (i = 0; i < trace->num_ops; i++)
+	{
+		w = (by_tag ? trace->ops[i].tid : trace->ops[i].index) % nthreads;
+		workers[w].opnums[workers[w].num_ops++] = i;
+	}
+
+	stats->secs = 0;
+	for (r = 0; r < runs; r++)
+	{
+		alloc->reset();
+		memset(slots, 0, trace->num_ids * sizeof(slot_t));
+		pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+		for (w = 0; w < nthreads; w++)
+			if (pthread_create(&workers[w].thread, NULL, replay, &workers[w]))
+				app_error("pthread_create failed in replay_trace");
+
+		/*
+		 * Let all threads go at once. The run lasts from the first
+		 * thread starting to the last one finishing; we may not get to
+		 * read the clock ourselves until long after the barrier.
+		 */
+		pthread_barrier_wait(&start_barrier);
+		for (w = 0; w < nthreads; w++)
+			pthread_join(workers[w].thread, NULL);
+		pthread_barrier_destroy(&start_barrier);
+		start = workers[0].start;
+		end = workers[0].end;
+		for (w = 1; w < nthreads; w++)
+		{
+			start = (workers[w].start < start) ? workers[w].start : start;
+			end = (workers[w].end > end) ? workers[w].end : end;
+		}
+		secs = end - start;
+
+		/* Give back whatever an unbalanced trace left allocated */
+		for (i = 0; i < trace->num_ids; i++)
+			if (slots[i].ptr != NULL)
+				alloc->free(slots[i].ptr);
+
+		if (stats->secs == 0 || secs < stats->secs)
+		{
+			stats->secs = secs;
+			stats->handoffs = 0;
+			for (w = 0; w < nthreads; w++)
+			{
+				stats->kops[w] = (workers[w].end > workers[w].start)
+									 ? workers[w].num_ops / 1e3 /
+										   (workers[w].end - workers[w].start)
+									 : 0;
+				stats->handoffs += workers[w].handoffs;
+			}
+		}
+	}
+
+	for (w = 0; w < nthreads; w++)
+		free(workers[w].opnums);
+}
+
+/*
+ * replay - Thread routine that replays one stream of requests
+ */
+static void *replay(void *arg)
+{
+	worker_t *w = (worker_t *)arg;
+	traceop_t *op;
+	slot_t *slot;
+	char *p;
+	int i;
+
+	w->handoffs = 0;
+	pthread_barrier_wait(&start_barrier);
+	w->start = now();
+
+	for (i = 0; i < w->num_ops; i++)
+	{
+		op = &trace->ops[w->opnums[i]];
+		slot = &slots[op->index];
+
+		/* Wait for the earlier requests on this block to complete */
+		while (__atomic_load_n(&slot->done, __ATOMIC_ACQUIRE) != op->seq)
+			sched_yield();
+		if (op->seq > 0 && slot->tid != w->id)
+			w->handoffs++;
+
+		switch (op->type)
+		{
+		case ALLOC:
+			if ((p = alloc->malloc(op->size)) == NULL)
+				app_error("malloc failed in replay");
+			slot->ptr = p;
+			break;
+
+		case REALLOC:
+			if ((p = alloc->realloc(slot->ptr, op->size)) == NULL)
+				app_error("realloc failed in replay");
+			slot->ptr = p;
+			break;
+
+		case FREE:
+			alloc->free(slot->ptr);
+			slot->ptr = NULL;
+			break;
+		}
+
+		/* Hand the block to whoever makes the next request on it */
+		slot->tid = w->id;
+		__atomic_store_n(&slot->done, op->seq + 1, __ATOMIC_RELEASE);
+	}
+
+	w->end = now();
+	return NULL;
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+	fprintf(stderr, "Usage: mtdriver [-huv] [-f <file>] [-t <dir>] "
+					"[-n <threads>] [-m tag|id] [-r <runs>]\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
+	fprintf(stderr, "\t-h         Print this message.\n");
+	fprintf(stderr, "\t-m tag|id  Split the trace by thread tag or by id "
+					"(default: tag if tagged).\n");
+	fprintf(stderr, "\t-n <n>     Replay with 1..n threads (default %d).\n",
+			DEFAULT_THREADS);
+	fprintf(stderr, "\t-r <runs>  Timed runs per thread count (default %d).\n",
+			DEFAULT_RUNS);
+	fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
+	fprintf(stderr, "\t-u         mm.c is thread-safe; don't serialize calls.\n");
+	fprintf(stderr, "\t-v         Print per-thread throughput.\n");
+}
@@ -0,0 +1,164 @@
+/*
+ * perfctr.c - hardware event counters via perf_event_open
+ *
+ * All events are opened in one group led by the cycle counter, so
+ * they are scheduled on the PMU together. We first ask for kernel and
+ * user counts; if that is refused (perf_event_paranoid >= 2 without
+ * root), we retry counting user space only. Events that the PMU (or
+ * the hypervisor) doesn't support are skipped and reported as -1.
+ * Counts are scaled by time_enabled/time_running in case the kernel
+ * had to multiplex the group.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "perfctr.h"
+
+const char *perf_names[PERF_NCOUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses",
+    "dtlb_misses", "branch_misses"
+};
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/* What perf_event_open should count for each of our events */
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} events[PERF_NCOUNTERS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                         (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+static int fds[PERF_NCOUNTERS] = {-1, -1, -1, -1, -1, -1};
+static int leader = -1;   /* fd of the group leader */
+
+/* open_event - open event e in the group, counting user space only if asked */
+static int open_event(int e, int group_fd, int user_only)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[e].type;
+    attr.config = events[e].config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = user_only;
+    attr.exclude_hv = user_only;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+/*
+ * open_group - open all events that the PMU supports. The leader is
+ *     the first event that can be opened at all.
+ */
+static int open_group(int user_only)
+{
+    int e, n = 0;
+
+    for (e = 0; e < PERF_NCOUNTERS; e++) {
+        fds[e] = open_event(e, leader, user_only);
+        if (fds[e] < 0)
+            continue;
+        if (leader < 0)
+            leader = fds[e];
+        n++;
+    }
+    return n;
+}
+
+int perf_init(int verbose)
+{
+    int e, n, user_only = 0;
+
+    if ((n = open_group(0)) == 0) {
+        user_only = 1;
+        n = open_group(1);
+    }
+    if (verbose) {
+        if (n == 0)
+            printf("Hardware event counters are not available.\n");
+        else {
+            printf("Counting %s events:", user_only ? "user-space" : "all");
+            for (e = 0; e < PERF_NCOUNTERS; e++)
+                if (fds[e] >= 0)
+                    printf(" %s", perf_names[e]);
+            printf("\n");
+        }
+    }
+    return n;
+}
+
+void perf_measure(perf_test_funct f, void *argp, int n, double *counts)
+{
+    uint64_t buf[3];   /* value, time_enabled, time_running */
+    int e, i;
+
+    if (leader >= 0) {
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    for (i = 0; i < n; i++)
+        f(argp);
+    if (leader >= 0)
+        ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    for (e = 0; e < PERF_NCOUNTERS; e++) {
+        counts[e] = -1;
+        if (fds[e] < 0 || read(fds[e], buf, sizeof(buf)) != sizeof(buf))
+            continue;
+        counts[e] = (double)buf[0];
+        if (buf[2] > 0 && buf[2] < buf[1])
+            counts[e] *= (double)buf[1] / buf[2];
+    }
+}
+
+void perf_deinit(void)
+{
+    int e;
+
+    for (e = 0; e < PERF_NCOUNTERS; e++) {
+        if (fds[e] >= 0)
+            close(fds[e]);
+        fds[e] = -1;
+    }
+    leader = -1;
+}
+
+#else /* !__linux__ */
+
+int perf_init(int verbose)
+{
+    if (verbose)
+        printf("Hardware event counters need Linux perf_event_open.\n");
+    return 0;
+}
+
+void perf_measure(perf_test_funct f, void *argp, int n, double *counts)
+{
+    int e;
+
+    for (e = 0; e < PERF_NCOUNTERS; e++)
+        counts[e] = -1;
+}
+
+void perf_deinit(void)
+{
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,39 @@
+/*
+ * perfctr.h - hardware event counters (Linux perf_event_open) for
+ *     explaining the throughput numbers of the driver
+ */
+#ifndef __PERFCTR_H_
+#define __PERFCTR_H_
+
+/* The events we count, in the order they are reported */
+#define PERF_CYCLES        0
+#define PERF_INSTRUCTIONS  1
+#define PERF_L1D_MISSES    2
+#define PERF_LLC_MISSES    3
+#define PERF_DTLB_MISSES   4
+#define PERF_BRANCH_MISSES 5
+#define PERF_NCOUNTERS     6
+
+/* Short column names for each event */
+extern const char *perf_names[PERF_NCOUNTERS];
+
+/* The test function takes a generic pointer as input */
+typedef void (*perf_test_funct)(void *);
+
+/*
+ * perf_init - open the counters. Returns the number of events that
+ *     could be opened (0 if perf_event_open is unavailable).
+ */
+int perf_init(int verbose);
+
+/*
+ * perf_measure - run f(argp) n times with the counters enabled. Sets
+ *     counts[e] to the total for each event, or to -1 if the event
+ *     could not be opened.
+ */
+void perf_measure(perf_test_funct f, void *argp, int n, double *counts);
+
+/* perf_deinit - close the counters */
+void perf_deinit(void);
+
+#endif /* __PERFCTR_H_ */
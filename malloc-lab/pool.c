@@ -0,0 +1,299 @@
+/*
+ * pool.c - fixed-size object pools with per-thread magazines (see pool.h)
+ *
+ * Three layers, fastest first:
+ *
+ *   1. the calling thread's loaded and previous magazine (no lock);
+ *   2. the pool's depot of full and empty magazines (pool lock);
+ *   3. the slab layer: a free list of single objects and the rest of
+ *      the current slab, which is mm_malloc'ed POOL_SLAB bytes at a
+ *      time (pool lock, plus heap_lock around mm.c).
+ *
+ * The per-thread caches live in a __thread array indexed by the
+ * pool's slot. A pool also has a generation number, so a thread that
+ * still holds magazines of a destroyed pool whose slot was reused
+ * notices and starts over with empty ones.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pool.h"
+#include "mm.h"
+#include "config.h"
+
+#define POOL_MAX 64				/* pools that can exist at once */
+#define MAG_ROUNDS 32			/* objects per magazine */
+#define POOL_SLAB (16 * 1024)	/* bytes of objects per slab */
+
+/* A stack of free objects, exchanged whole between threads */
+typedef struct magazine
+{
+	struct magazine *next; /* next magazine in a depot list */
+	struct magazine *all;  /* next magazine of the pool, for destroy */
+	int rounds;			   /* objects in objs */
+	void *objs[MAG_ROUNDS];
+} magazine_t;
+
+/* One thread's magazines for one pool */
+typedef struct
+{
+	mm_pool_t *pool;	/* pool these magazines belong to */
+	unsigned gen;		/* its generation when they were taken */
+	magazine_t *loaded; /* allocs pop from and frees push to this one */
+	magazine_t *prev;	/* the one before, full or empty */
+} pool_cache_t;
+
+struct mm_pool
+{
+	int slot;			   /* index in pools and in every pool_caches */
+	unsigned gen;		   /* generation, to spot stale caches */
+	size_t objsize;		   /* object size, rounded up to align */
+	size_t align;		   /* object alignment */
+	pthread_mutex_t lock;  /* guards the depot and the slab layer */
+	magazine_t *full;	   /* depot: full magazines */
+	magazine_t *empty;	   /* depot: empty magazines */
+	magazine_t *mags;	   /* every magazine of the pool */
+	void *objs;			   /* slab layer: free objects, linked by first word */
+	char *top;			   /* next unused object of the current slab */
+	char *end;			   /* end of the current slab */
+	void *slabs;		   /* the slabs, linked by first word */
+};
+
+static mm_pool_t *pools[POOL_MAX];	/* live pools by slot */
+static unsigned pool_gen;			/* last generation handed out */
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER; /* mm.c, pools */
+static __thread pool_cache_t pool_caches[POOL_MAX];
+
+/* Round n up to a multiple of align (a power of two) */
+#define ROUND_UP(n, align) (((n) + (align) - 1) & ~((align) - 1))
+
+/*
+ * heap_malloc, heap_free - mm_malloc and mm_free under heap_lock
+ */
+static void *heap_malloc(size_t size)
+{
+	void *p;
+
+	pthread_mutex_lock(&heap_lock);
+	p = mm_malloc(size);
+	pthread_mutex_unlock(&heap_lock);
+	return p;
+}
+
+static void heap_free(void *p)
+{
+	pthread_mutex_lock(&heap_lock);
+	mm_free(p);
+	pthread_mutex_unlock(&heap_lock);
+}
+
+/*
+ * get_cache - the calling thread's magazines for pool
+ */
+static pool_cache_t *get_cache(mm_pool_t *pool)
+{
+	pool_cache_t *c = &pool_caches[pool->slot];
+
+	if (c->pool != pool || c->gen != pool->gen)
+	{
+		c->pool = pool;
+		c->gen = pool->gen;
+		c->loaded = c->prev = NULL;
+	}
+	return c;
+}
+
+/*
+ * new_magazine - an empty magazine from the depot or the heap. Called
+ *     with the pool lock held; returns NULL if out of memory.
+ */
+static magazine_t *new_magazine(mm_pool_t *pool)
+{
+	magazine_t *m = pool->empty;
+
+	if (m != NULL)
+	{
+		pool->empty = m->next;
+		return m;
+	}
+	if ((m = heap_malloc(sizeof(magazine_t))) == NULL)
+		return NULL;
+	m->all = pool->mags;
+	pool->mags = m;
+	m->rounds = 0;
+	return m;
+}
+
+/*
+ * slab_alloc - one object from the slab layer, carving a new slab if
+ *     needed. Called with the pool lock held; returns NULL if out of
+ *     memory.
+ */
+static void *slab_alloc(mm_pool_t *pool)
+{
+	void *obj = pool->objs;
+	char *slab;
+
+	if (obj != NULL)
+	{
+		pool->objs = *(void **)obj;
+		return obj;
+	}
+	if (pool->top + pool->objsize > pool->end)
+	{
+		/* the first word links the slabs; objects start aligned after it */
+		if ((slab = heap_malloc(POOL_SLAB + pool->align + sizeof(void *))) == NULL)
+			return NULL;
+		*(void **)slab = pool->slabs;
+		pool->slabs = slab;
+		pool->top = (char *)ROUND_UP((uintptr_t)(slab + sizeof(void *)),
+									 pool->align);
+		pool->end = pool->top + POOL_SLAB;
+	}
+	obj = pool->top;
+	pool->top += pool->objsize;
+	return obj;
+}
+
+mm_pool_t *mm_pool_create(size_t objsize, size_t align)
+{
+	mm_pool_t *pool;
+	int slot;
+
+	if (align == 0)
+		align = ALIGNMENT;
+	if ((pool = calloc(1, sizeof(mm_pool_t))) == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&heap_lock);
+	for (slot = 0; slot < POOL_MAX && pools[slot] != NULL; slot++)
+		;
+	if (slot < POOL_MAX)
+	{
+		pools[slot] = pool;
+		pool->gen = ++pool_gen;
+	}
+	pthread_mutex_unlock(&heap_lock);
+	if (slot == POOL_MAX)
+	{
+		free(pool);
+		return NULL;
+	}
+
+	pool->slot = slot;
+	pool->align = align;
+	pool->objsize = ROUND_UP(objsize < sizeof(void *) ? sizeof(void *) : objsize,
+							 align);
+	pthread_mutex_init(&pool->lock, NULL);
+	return pool;
+}
+
+void *mm_pool_alloc(mm_pool_t *pool)
+{
+	pool_cache_t *c = get_cache(pool);
+	magazine_t *m;
+	void *obj;
+
+	/* Fast path: pop from the loaded magazine */
+	if (c->loaded != NULL && c->loaded->rounds > 0)
+		return c->loaded->objs[--c->loaded->rounds];
+
+	/* The previous magazine is full: swap it in */
+	if (c->prev != NULL && c->prev->rounds > 0)
+	{
+		m = c->loaded;
+		c->loaded = c->prev;
+		c->prev = m;
+		return c->loaded->objs[--c->loaded->rounds];
+	}
+
+	/* Trade the empty previous magazine for a full one from the depot */
+	pthread_mutex_lock(&pool->lock);
+	if ((m = pool->full) != NULL)
+	{
+		pool->full = m->next;
+		if (c->prev != NULL)
+		{
+			c->prev->next = pool->empty;
+			pool->empty = c->prev;
+		}
+		c->prev = c->loaded;
+		c->loaded = m;
+		pthread_mutex_unlock(&pool->lock);
+		return m->objs[--m->rounds];
+	}
+
+	/* The depot has none: take one object from the slab layer */
+	obj = slab_alloc(pool);
+	pthread_mutex_unlock(&pool->lock);
+	return obj;
+}
+
+void mm_pool_free(mm_pool_t *pool, void *obj)
+{
+	pool_cache_t *c = get_cache(pool);
+	magazine_t *m;
+
+	/* Fast path: push on the loaded magazine */
+	if (c->loaded != NULL && c->loaded->rounds < MAG_ROUNDS)
+	{
+		c->loaded->objs[c->loaded->rounds++] = obj;
+		return;
+	}
+
+	/* The previous magazine is empty: swap it in */
+	if (c->prev != NULL && c->prev->rounds == 0)
+	{
+		m = c->loaded;
+		c->loaded = c->prev;
+		c->prev = m;
+		c->loaded->objs[c->loaded->rounds++] = obj;
+		return;
+	}
+
+	/* Trade the full previous magazine for an empty one from the depot */
+	pthread_mutex_lock(&pool->lock);
+	if ((m = new_magazine(pool)) == NULL)
+	{
+		/* no memory for a magazine: give the object to the slab layer */
+		*(void **)obj = pool->objs;
+		pool->objs = obj;
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+	if (c->prev != NULL)
+	{
+		c->prev->next = pool->full;
+		pool->full = c->prev;
+	}
+	c->prev = c->loaded;
+	c->loaded = m;
+	pthread_mutex_unlock(&pool->lock);
+	m->objs[m->rounds++] = obj;
+}
+
+void mm_pool_destroy(mm_pool_t *pool)
+{
+	magazine_t *m;
+	void *slab;
+
+	while ((m = pool->mags) != NULL)
+	{
+		pool->mags = m->all;
+		heap_free(m);
+	}
+	while ((slab = pool->slabs) != NULL)
+	{
+		pool->slabs = *(void **)slab;
+		heap_free(slab);
+	}
+
+	pthread_mutex_lock(&heap_lock);
+	pools[pool->slot] = NULL;
+	pthread_mutex_unlock(&heap_lock);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
@@ -0,0 +1,42 @@
+/*
+ * pool.h - fixed-size object pools with per-thread magazines
+ *
+ * A pool hands out objects of one size. Each thread keeps up to two
+ * magazines (small stacks of free objects) per pool, so that most
+ * allocs and frees are a push or pop with no lock and no size
+ * rounding or fit search. Full and empty magazines are exchanged
+ * with the pool's depot under a lock, and the depot is refilled from
+ * slabs carved out of the mm.c heap (Bonwick, "Magazines and Vmem",
+ * USENIX 2001).
+ *
+ * mm.c is not thread-safe: the pools serialize their own mm_malloc
+ * calls, but callers that use mm_malloc from several threads at once
+ * must do the same.
+ */
+#ifndef __POOL_H_
+#define __POOL_H_
+
+#include <stddef.h>
+
+typedef struct mm_pool mm_pool_t;
+
+/*
+ * Make a pool of objects of objsize bytes aligned to align (a power
+ * of two, or 0 for ALIGNMENT). Returns NULL if out of memory or if
+ * POOL_MAX pools already exist.
+ */
+mm_pool_t *mm_pool_create(size_t objsize, size_t align);
+
+/* Allocate one object, or NULL when the heap is full */
+void *mm_pool_alloc(mm_pool_t *pool);
+
+/* Free an object allocated from the same pool */
+void mm_pool_free(mm_pool_t *pool, void *obj);
+
+/*
+ * Give all slabs and magazines back to mm.c. No thread may use the
+ * pool during or after the call.
+ */
+void mm_pool_destroy(mm_pool_t *pool);
+
+#endif /* __POOL_H_ */
@@ -0,0 +1,281 @@
+/*
+ * pooldriver.c - Fixed-size pool vs. locked mm malloc under threads
+ *
+ * Each of -n threads keeps a window of -w live objects of -s bytes
+ * and replaces a random one -o times: free the old object, allocate
+ * a new one and touch its first byte. The loop runs once against
+ * mm_malloc/mm_free behind one global lock (mm.c is not
+ * thread-safe), and once against an object pool (pool.c), whose
+ * per-thread magazines take the lock only when they run full or
+ * empty.
+ *
+ * For each thread count from 1 to -n we report the throughput of
+ * both allocators (best of -r runs) and the peak heap size.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mm.h"
+#include "memlib.h"
+#include "pool.h"
+#include "config.h"
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXTHREADS 64		 /* max threads (-n) */
+#define DEFAULT_THREADS 4	 /* threads (-n) */
+#define DEFAULT_SIZE 64		 /* object size in bytes (-s) */
+#define DEFAULT_OPS 1000000	 /* replacements per thread (-o) */
+#define DEFAULT_WINDOW 1024	 /* live objects per thread (-w) */
+#define DEFAULT_RUNS 3		 /* timed runs per allocator, best is kept (-r) */
+
+/******************************
+ * The key compound data types
+ *****************************/
+
+/* What one thread does */
+typedef struct
+{
+	mm_pool_t *pool;  /* the pool, or NULL for locked mm malloc */
+	unsigned seed;	  /* for rand_r */
+	int ops;		  /* replacements */
+	int window;		  /* live objects */
+	size_t size;	  /* object size */
+	char **objs;	  /* the live objects */
+} worker_t;
+
+/********************
+ * Global variables
+ *******************/
+static pthread_mutex_t mm_lock = PTHREAD_MUTEX_INITIALIZER; /* for mm malloc */
+
+/*********************
+ * Function prototypes
+ *********************/
+static double run(int nthreads, size_t size, int ops, int window, int use_pool);
+static void *worker(void *vargp);
+static void *obj_alloc(worker_t *w);
+static void obj_free(worker_t *w, void *p);
+static double now(void);
+static void usage(void);
+static void app_error(char *msg);
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+	int c, n, r;
+	int nthreads = DEFAULT_THREADS; /* max number of threads */
+	size_t size = DEFAULT_SIZE;		/* object size */
+	int ops = DEFAULT_OPS;			/* replacements per thread */
+	int window = DEFAULT_WINDOW;	/* live objects per thread */
+	int runs = DEFAULT_RUNS;		/* timed runs per allocator */
+	double secs, mm_secs, pool_secs;
+	size_t mm_peak, pool_peak;
+
+	while ((c = getopt(argc, argv, "n:s:o:w:r:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'n': /* Max number of threads */
+			nthreads = atoi(optarg);
+			if (nthreads < 1 || nthreads > MAXTHREADS)
+				app_error("-n out of range");
+			break;
+		case 's': /* Object size */
+			if ((size = (size_t)atol(optarg)) < 1)
+				app_error("-s must be at least 1");
+			break;
+		case 'o': /* Replacements per thread */
+			if ((ops = atoi(optarg)) < 1)
+				app_error("-o must be at least 1");
+			break;
+		case 'w': /* Live objects per thread */
+			if ((window = atoi(optarg)) < 1)
+				app_error("-w must be at least 1");
+			break;
+		case 'r': /* Timed runs per allocator */
+			if ((runs = atoi(optarg)) < 1)
+				app_error("-r must be at least 1");
+			break;
+		case 'h': /* Print this message */
+			usage();
+			exit(0);
+		default:
+			usage();
+			exit(1);
+		}
+	}
+
+	/* Initialize the simulated memory system in memlib.c */
+	mem_init();
+
+	printf("%d-byte objects, %d live and %d replacements per thread\n",
+		   (int)size, window, ops);
+	printf("%-8s%12s%8s%12s%8s\n", "threads", "mm Kops", "mm KB",
+		   "pool Kops", "pool KB");
+	for (n = 1; n <= nthreads; n++)
+	{
+		mm_secs = pool_secs = 0;
+		for (r = 0; r < runs; r++)
+		{
+			secs = run(n, size, ops, window, 0);
+			if (mm_secs == 0 || secs < mm_secs)
+				mm_secs = secs;
+			mm_peak = mem_heap_peak();
+			secs = run(n, size, ops, window, 1);
+			if (pool_secs == 0 || secs < pool_secs)
+				pool_secs = secs;
+			pool_peak = mem_heap_peak();
+		}
+		printf("%-8d%12.0f%8.0f%12.0f%8.0f\n", n,
+			   2.0 * n * ops / 1e3 / mm_secs, mm_peak / 1024.0,
+			   2.0 * n * ops / 1e3 / pool_secs, pool_peak / 1024.0);
+	}
+
+	mem_deinit();
+	exit(0);
+}
+
+/*
+ * run - Start nthreads workers on an empty heap and return the time
+ *     until the last one is done
+ */
+static double run(int nthreads, size_t size, int ops, int window, int use_pool)
+{
+	pthread_t tids[MAXTHREADS];
+	worker_t workers[MAXTHREADS];
+	mm_pool_t *pool = NULL;
+	double start, secs;
+	int i, j;
+
+	mem_reset_brk();
+	if (mm_init() < 0)
+		app_error("mm_init failed in run");
+	if (use_pool && (pool = mm_pool_create(size, 0)) == NULL)
+		app_error("mm_pool_create failed in run");
+
+	for (i = 0; i < nthreads; i++)
+	{
+		workers[i].pool = pool;
+		workers[i].seed = i + 1;
+		workers[i].ops = ops;
+		workers[i].window = window;
+		workers[i].size = size;
+		if ((workers[i].objs = calloc(window, sizeof(char *))) == NULL)
+			app_error("calloc failed in run");
+	}
+
+	start = now();
+	for (i = 0; i < nthreads; i++)
+		pthread_create(&tids[i], NULL, worker, &workers[i]);
+	for (i = 0; i < nthreads; i++)
+		pthread_join(tids[i], NULL);
+	secs = now() - start;
+
+	for (i = 0; i < nthreads; i++)
+	{
+		for (j = 0; j < window; j++)
+			if (workers[i].objs[j] != NULL)
+				obj_free(&workers[i], workers[i].objs[j]);
+		free(workers[i].objs);
+	}
+	if (pool != NULL)
+		mm_pool_destroy(pool);
+	return secs;
+}
+
+/*
+ * worker - Thread routine: replace random objects of the window
+ */
+static void *worker(void *vargp)
+{
+	worker_t *w = (worker_t *)vargp;
+	int i, slot;
+
+	for (i = 0; i < w->ops; i++)
+	{
+		slot = rand_r(&w->seed) % w->window;
+		if (w->objs[slot] != NULL)
+			obj_free(w, w->objs[slot]);
+		if ((w->objs[slot] = obj_alloc(w)) == NULL)
+			app_error("allocation failed in worker");
+		w->objs[slot][0] = (char)i;
+	}
+	return NULL;
+}
+
+/*
+ * obj_alloc, obj_free - One object from the pool or from mm malloc
+ */
+static void *obj_alloc(worker_t *w)
+{
+	void *p;
+
+	if (w->pool != NULL)
+		return mm_pool_alloc(w->pool);
+	pthread_mutex_lock(&mm_lock);
+	p = mm_malloc(w->size);
+	pthread_mutex_unlock(&mm_lock);
+	return p;
+}
+
+static void obj_free(worker_t *w, void *p)
+{
+	if (w->pool != NULL)
+	{
+		mm_pool_free(w->pool, p);
+		return;
+	}
+	pthread_mutex_lock(&mm_lock);
+	mm_free(p);
+	pthread_mutex_unlock(&mm_lock);
+}
+
+/*
+ * now - wall clock time in seconds
+ */
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+	fprintf(stderr, "Usage: pooldriver [-h] [-n <threads>] [-s <bytes>] "
+					"[-o <ops>] [-w <objs>] [-r <runs>]\n");
+	fprintf(stderr, "Options\n");
+	fprintf(stderr, "\t-h           Print this message.\n");
+	fprintf(stderr, "\t-n <threads> Run with 1 to <threads> threads "
+					"(default %d).\n", DEFAULT_THREADS);
+	fprintf(stderr, "\t-o <ops>     Replacements per thread (default %d).\n",
+			DEFAULT_OPS);
+	fprintf(stderr, "\t-r <runs>    Timed runs per allocator (default %d).\n",
+			DEFAULT_RUNS);
+	fprintf(stderr, "\t-s <bytes>   Object size (default %d).\n", DEFAULT_SIZE);
+	fprintf(stderr, "\t-w <objs>    Live objects per thread (default %d).\n",
+			DEFAULT_WINDOW);
+}
@@ -0,0 +1,608 @@
+/*
+ * report.c - machine-readable output of the driver results
+ *
+ * report_json and report_csv dump the per-trace stats so that they
+ * can be collected by dashboards. report_compare reads back a JSON
+ * file written by an earlier run and flags traces whose utilization
+ * (peak or time-averaged) dropped or whose throughput dropped by a statistically significant
+ * amount (one-sided Welch t-test; over all the traces compared, an
+ * unchanged build is flagged with chance THRU_ALPHA).
+ * The runs of one process share its state (its CPU, memory layout, the
+ * load of the machine at that moment), so they spread less than
+ * separate processes do. A side timed in separate processes (--procs)
+ * brings its own spread between them, and lends it to a side that
+ * wasn't; if neither was, the test adds a spread of --noise to each.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "report.h"
+#include "config.h"
+
+#define MAXNAME 256		 /* max length of a trace name in the baseline */
+#define UTIL_EPSILON 1e-6 /* utilization is deterministic, any drop counts */
+#define THRU_TOLERANCE 0.05 /* smallest relative throughput drop flagged */
+#define THRU_ALPHA 0.05		/* chance of any throughput false alarm */
+
+/* One trace record read back from a baseline file */
+typedef struct
+{
+	char name[MAXNAME];	 /* trace file name */
+	char allocator[16];	 /* "mm" or "libc" */
+	int valid;
+	double util;
+	double util_avg;
+	double kops;
+	double kops_sd;
+	int runs;
+	int procs;
+} base_t;
+
+/* Cursor into the baseline text */
+typedef struct
+{
+	char *p;
+} jcur_t;
+
+/*
+ * kops - throughput of a trace in Kops/sec, as shown by printresults
+ */
+static double kops(stats_t *s)
+{
+	return (s->secs > 0) ? (s->ops / 1e3) / s->secs : 0.0;
+}
+
+/*
+ * json_string - print s as a JSON string literal
+ */
+static void json_string(FILE *fp, char *s)
+{
+	fputc('"', fp);
+	for (; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fputc('\\', fp);
+		fputc(*s, fp);
+	}
+	fputc('"', fp);
+}
+
+/*
+ * json_perf - print the per-op hardware event counts of a trace
+ */
+static void json_perf(FILE *fp, stats_t *s)
+{
+	int e, first = 1;
+
+	fprintf(fp, ", \"perf\": {");
+	for (e = 0; e < PERF_NCOUNTERS; e++)
+	{
+		if (s->perf[e] < 0)
+			continue;
+		fprintf(fp, "%s\"%s\": %.3f", first ? "" : ", ", perf_names[e],
+				s->perf[e]);
+		first = 0;
+	}
+	fprintf(fp, "}");
+}
+
+/*
+ * json_traces - print one JSON object per trace for a single allocator
+ */
+static void json_traces(FILE *fp, char *allocator, char **tracefiles,
+						int n, stats_t *stats, int *first)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+	{
+		fprintf(fp, "%s\n    {\"name\": ", *first ? "" : ",");
+		*first = 0;
+		json_string(fp, tracefiles[i]);
+		fprintf(fp, ", \"allocator\": \"%s\", \"valid\": %d", allocator,
+				stats[i].valid);
+		fprintf(fp, ", \"ops\": %.0f, \"allocs\": %d, \"frees\": %d, "
+					"\"reallocs\": %d",
+				stats[i].ops, stats[i].allocs, stats[i].frees,
+				stats[i].reallocs);
+		if (stats[i].valid)
+			fprintf(fp, ", \"util\": %.6f, \"secs\": %.9f, \"kops\": %.3f, "
+						"\"kops_sd\": %.3f, \"runs\": %d, \"procs\": %d, "
+						"\"peak_heap\": %lu, "
+						"\"malloc_cycles\": %.1f, \"free_cycles\": %.1f, "
+						"\"realloc_cycles\": %.1f",
+					stats[i].util, stats[i].secs, kops(&stats[i]),
+					stats[i].kops_sd, stats[i].runs, stats[i].procs,
+					(unsigned long)stats[i].heap, stats[i].cyc_malloc,
+					stats[i].cyc_free, stats[i].cyc_realloc);
+		if (stats[i].valid && !strcmp(allocator, "mm"))
+			fprintf(fp, ", \"util_avg\": %.6f, \"peak_live\": %lu, "
+						"\"trimmed_heap\": %lu, \"sbrk_calls\": %ld",
+					stats[i].util_avg, (unsigned long)stats[i].live,
+					(unsigned long)stats[i].trimmed, stats[i].sbrks);
+		if (stats[i].valid && stats[i].lat_ops > 0)
+			fprintf(fp, ", \"lat_p50\": %.0f, \"lat_p99\": %.0f, "
+						"\"lat_max\": %.0f, \"lat_worst\": %.0f",
+					stats[i].lat_p50, stats[i].lat_p99, stats[i].lat_max,
+					stats[i].lat_worst);
+		if (stats[i].valid && stats[i].counted)
+			json_perf(fp, &stats[i]);
+		fprintf(fp, "}");
+	}
+}
+
+/*
+ * report_json - write the results of a run as a JSON document
+ */
+void report_json(FILE *fp, char **tracefiles, int n,
+				 stats_t *mm_stats, stats_t *libc_stats, double perfindex)
+{
+	int first = 1;
+
+	fprintf(fp, "{\n  \"util_weight\": %.2f,\n", UTIL_WEIGHT);
+	fprintf(fp, "  \"avg_libc_thruput\": %.0f,\n", AVG_LIBC_THRUPUT);
+	fprintf(fp, "  \"perfindex\": %.3f,\n", perfindex);
+	fprintf(fp, "  \"traces\": [");
+	json_traces(fp, "mm", tracefiles, n, mm_stats, &first);
+	if (libc_stats)
+		json_traces(fp, "libc", tracefiles, n, libc_stats, &first);
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+/*
+ * csv_traces - print one CSV row per trace for a single allocator
+ */
+static void csv_traces(FILE *fp, char *allocator, char **tracefiles,
+					   int n, stats_t *stats)
+{
+	int i, e;
+
+	for (i = 0; i < n; i++)
+	{
+		fprintf(fp, "%s,%s,%d,%.0f,%d,%d,%d,", allocator, tracefiles[i],
+				stats[i].valid, stats[i].ops, stats[i].allocs,
+				stats[i].frees, stats[i].reallocs);
+		if (stats[i].valid)
+			fprintf(fp, "%.6f,%.9f,%.3f,%.3f,%d,%d,%lu,%.1f,%.1f,%.1f",
+					stats[i].util, stats[i].secs, kops(&stats[i]),
+					stats[i].kops_sd, stats[i].runs, stats[i].procs,
+					(unsigned long)stats[i].heap, stats[i].cyc_malloc,
+					stats[i].cyc_free, stats[i].cyc_realloc);
+		else
+			fprintf(fp, ",,,,,,,,,");
+		if (stats[i].valid && !strcmp(allocator, "mm"))
+			fprintf(fp, ",%.6f,%lu,%lu,%ld", stats[i].util_avg,
+					(unsigned long)stats[i].live,
+					(unsigned long)stats[i].trimmed, stats[i].sbrks);
+		else
+			fprintf(fp, ",,,,");
+		for (e = 0; e < PERF_NCOUNTERS; e++)
+		{
+			fprintf(fp, ",");
+			if (stats[i].valid && stats[i].counted && stats[i].perf[e] >= 0)
+				fprintf(fp, "%.3f", stats[i].perf[e]);
+		}
+		fprintf(fp, "\n");
+	}
+}
+
+/*
+ * report_csv - write the results of a run as CSV
+ */
+void report_csv(FILE *fp, char **tracefiles, int n,
+				stats_t *mm_stats, stats_t *libc_stats)
+{
+	int e;
+
+	fprintf(fp, "allocator,trace,valid,ops,allocs,frees,reallocs,"
+				"util,secs,kops,kops_sd,runs,procs,peak_heap,"
+				"malloc_cycles,free_cycles,realloc_cycles,"
+				"util_avg,peak_live,trimmed_heap,sbrk_calls");
+	for (e = 0; e < PERF_NCOUNTERS; e++)
+		fprintf(fp, ",%s_per_op", perf_names[e]);
+	fprintf(fp, "\n");
+	csv_traces(fp, "mm", tracefiles, n, mm_stats);
+	if (libc_stats)
+		csv_traces(fp, "libc", tracefiles, n, libc_stats);
+}
+
+/*****************************************************************
+ * A minimal JSON reader, just enough to read back report_json files
+ ****************************************************************/
+
+static void json_ws(jcur_t *c)
+{
+	while (isspace((unsigned char)*c->p))
+		c->p++;
+}
+
+/* json_str - read a string literal into buf (truncated to len) */
+static int json_str(jcur_t *c, char *buf, int len)
+{
+	int i = 0;
+
+	json_ws(c);
+	if (*c->p != '"')
+		return 0;
+	for (c->p++; *c->p && *c->p != '"'; c->p++)
+	{
+		if (*c->p == '\\' && c->p[1])
+			c->p++;
+		if (buf && i < len - 1)
+			buf[i++] = *c->p;
+	}
+	if (buf)
+		buf[i] = '\0';
+	if (*c->p != '"')
+		return 0;
+	c->p++;
+	return 1;
+}
+
+/* json_skip - skip over any JSON value */
+static int json_skip(jcur_t *c)
+{
+	int depth = 0;
+
+	json_ws(c);
+	if (*c->p == '"')
+		return json_str(c, NULL, 0);
+	if (*c->p != '{' && *c->p != '[')
+	{
+		while (*c->p && !strchr(",}] \t\r\n", *c->p))
+			c->p++;
+		return 1;
+	}
+	do
+	{
+		if (*c->p == '"')
+		{
+			if (!json_str(c, NULL, 0))
+				return 0;
+			continue;
+		}
+		if (*c->p == '{' || *c->p == '[')
+			depth++;
+		else if (*c->p == '}' || *c->p == ']')
+			depth--;
+		else if (*c->p == '\0')
+			return 0;
+		c->p++;
+	} while (depth > 0);
+	return 1;
+}
+
+/* json_expect - consume the punctuation character ch */
+static int json_expect(jcur_t *c, char ch)
+{
+	json_ws(c);
+	if (*c->p != ch)
+		return 0;
+	c->p++;
+	return 1;
+}
+
+/* json_record - read one trace object into rec */
+static int json_record(jcur_t *c, base_t *rec)
+{
+	char key[MAXNAME];
+
+	memset(rec, 0, sizeof(base_t));
+	if (!json_expect(c, '{'))
+		return 0;
+	json_ws(c);
+	if (*c->p == '}')
+		return json_expect(c, '}');
+	do
+	{
+		if (!json_str(c, key, sizeof(key)) || !json_expect(c, ':'))
+			return 0;
+		json_ws(c);
+		if (!strcmp(key, "name"))
+			json_str(c, rec->name, sizeof(rec->name));
+		else if (!strcmp(key, "allocator"))
+			json_str(c, rec->allocator, sizeof(rec->allocator));
+		else if (!strcmp(key, "valid"))
+			rec->valid = (int)strtol(c->p, &c->p, 10);
+		else if (!strcmp(key, "util"))
+			rec->util = strtod(c->p, &c->p);
+		else if (!strcmp(key, "util_avg"))
+			rec->util_avg = strtod(c->p, &c->p);
+		else if (!strcmp(key, "kops"))
+			rec->kops = strtod(c->p, &c->p);
+		else if (!strcmp(key, "kops_sd"))
+			rec->kops_sd = strtod(c->p, &c->p);
+		else if (!strcmp(key, "runs"))
+			rec->runs = (int)strtol(c->p, &c->p, 10);
+		else if (!strcmp(key, "procs"))
+			rec->procs = (int)strtol(c->p, &c->p, 10);
+		else if (!json_skip(c))
+			return 0;
+		json_ws(c);
+	} while (*c->p == ',' && c->p++);
+	return json_expect(c, '}');
+}
+
+/*
+ * read_baseline - read the "traces" array of a report_json file.
+ *     Returns a malloc'ed array of records and sets *count.
+ */
+static base_t *read_baseline(char *path, int *count)
+{
+	FILE *fp;
+	long len;
+	char *text;
+	char key[MAXNAME];
+	base_t *recs = NULL, *grown;
+	int n = 0, cap = 0, ok = 0;
+	jcur_t c;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return NULL;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	rewind(fp);
+	if ((text = malloc(len + 1)) == NULL)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	len = fread(text, 1, len, fp);
+	text[len] = '\0';
+	fclose(fp);
+
+	c.p = text;
+	if (!json_expect(&c, '{'))
+		goto done;
+	do
+	{
+		if (!json_str(&c, key, sizeof(key)) || !json_expect(&c, ':'))
+			goto done;
+		if (strcmp(key, "traces"))
+		{
+			if (!json_skip(&c))
+				goto done;
+			json_ws(&c);
+			continue;
+		}
+		if (!json_expect(&c, '['))
+			goto done;
+		json_ws(&c);
+		while (*c.p == '{')
+		{
+			if (n == cap)
+			{
+				cap = cap ? 2 * cap : 32;
+				if ((grown = realloc(recs, cap * sizeof(base_t))) == NULL)
+					goto done;
+				recs = grown;
+			}
+			if (!json_record(&c, &recs[n++]))
+				goto done;
+			json_ws(&c);
+			if (*c.p == ',')
+				c.p++;
+			json_ws(&c);
+		}
+		if (!json_expect(&c, ']'))
+			goto done;
+		ok = 1;
+		json_ws(&c);
+	} while (*c.p == ',' && c.p++);
+
+done:
+	free(text);
+	if (!ok)
+	{
+		free(recs);
+		return NULL;
+	}
+	*count = n;
+	return recs;
+}
+
+/*
+ * beta_frac - continued fraction of the regularized incomplete beta
+ *     function I_x(a, b), for x < (a + 1) / (a + b + 2)
+ */
+static double beta_frac(double a, double b, double x)
+{
+	double c = 1, d, h, num;
+	int m;
+
+	d = 1 - (a + b) * x / (a + 1);
+	d = 1 / ((fabs(d) < 1e-300) ? 1e-300 : d);
+	h = d;
+	for (m = 1; m <= 200; m++)
+	{
+		/* even step, then odd step */
+		num = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+		d = 1 + num * d;
+		c = 1 + num / c;
+		d = 1 / ((fabs(d) < 1e-300) ? 1e-300 : d);
+		c = (fabs(c) < 1e-300) ? 1e-300 : c;
+		h *= d * c;
+		num = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+		d = 1 + num * d;
+		c = 1 + num / c;
+		d = 1 / ((fabs(d) < 1e-300) ? 1e-300 : d);
+		c = (fabs(c) < 1e-300) ? 1e-300 : c;
+		h *= d * c;
+		if (fabs(d * c - 1) < 1e-12)
+			break;
+	}
+	return h;
+}
+
+/*
+ * t_tail - chance that Student's t with df degrees of freedom exceeds
+ *     t > 0, i.e. I_x(df/2, 1/2) / 2 with x = df / (df + t^2)
+ */
+static double t_tail(double t, double df)
+{
+	double a = df / 2, b = 0.5, x = df / (df + t * t);
+	double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) +
+					   a * log(x) + b * log(1 - x));
+
+	if (x < (a + 1) / (a + b + 2))
+		return front * beta_frac(a, b, x) / a / 2;
+	return (1 - front * beta_frac(b, a, 1 - x) / b) / 2;
+}
+
+/*
+ * t_crit - one-sided critical value of Student's t at level alpha
+ *     (the t that is exceeded with chance alpha), by bisection
+ */
+static double t_crit(double df, double alpha)
+{
+	double lo = 0, hi = 1e4, mid;
+	int i;
+
+	if (df < 1)
+		df = 1;
+	for (i = 0; i < 100; i++)
+	{
+		mid = (lo + hi) / 2;
+		if (t_tail(mid, df) > alpha)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return hi;
+}
+
+/*
+ * thru_regressed - Did the throughput drop from base to cur?
+ *     The drop must exceed THRU_TOLERANCE and be significant at level
+ *     alpha under Welch's t-test. If a side was timed in separate processes
+ *     (--procs), its mean varies by the spread between them over their
+ *     number; a side timed in one process varies by the other side's
+ *     spread, relative to its mean. If neither was, each side's mean
+ *     varies by its spread over the runs (if it has repeated runs)
+ *     plus noise times the mean, the spread between separate
+ *     processes, which more runs within one process don't average out.
+ */
+static int thru_regressed(base_t *base, stats_t *cur, double noise,
+						  double alpha, double *tstat)
+{
+	double mb = base->kops, mc = kops(cur);
+	double vb = 0, vc = 0, se, df = 1e9;
+	double rb, rc; /* spread between processes, relative to the mean */
+	int nb, nc;	   /* processes the spread of each side comes from */
+
+	*tstat = 0;
+	if ((mb - mc) <= THRU_TOLERANCE * mb)
+		return 0;
+	if (base->procs >= 2 || cur->procs >= 2)
+	{
+		rb = (base->procs >= 2) ? base->kops_sd / mb : cur->kops_sd / mc;
+		nb = (base->procs >= 2) ? base->procs : cur->procs;
+		rc = (cur->procs >= 2) ? cur->kops_sd / mc : rb;
+		nc = (cur->procs >= 2) ? cur->procs : nb;
+		vb = rb * rb * mb * mb / ((base->procs >= 2) ? base->procs : 1);
+		vc = rc * rc * mc * mc / ((cur->procs >= 2) ? cur->procs : 1);
+		if (vb + vc > 0)
+			df = (vb + vc) * (vb + vc) /
+				 (vb * vb / (nb - 1) + vc * vc / (nc - 1));
+	}
+	else
+	{
+		if (base->runs >= 2 && cur->runs >= 2)
+		{
+			vb = base->kops_sd * base->kops_sd / base->runs;
+			vc = cur->kops_sd * cur->kops_sd / cur->runs;
+			if (vb + vc > 0)
+				df = (vb + vc) * (vb + vc) /
+					 (vb * vb / (base->runs - 1) + vc * vc / (cur->runs - 1));
+		}
+		vb += noise * noise * mb * mb;
+		vc += noise * noise * mc * mc;
+	}
+	se = sqrt(vb + vc);
+	if (se == 0)
+		return 1;
+	*tstat = (mb - mc) / se;
+	return *tstat > t_crit(df, alpha);
+}
+
+/*
+ * compare_traces - compare one allocator's results against the baseline
+ */
+static int compare_traces(char *allocator, char **tracefiles, int n,
+						  stats_t *stats, base_t *recs, int nrecs,
+						  double noise, double alpha)
+{
+	int i, j, regressions = 0;
+	double t;
+	base_t *b;
+
+	for (i = 0; i < n; i++)
+	{
+		for (b = NULL, j = 0; j < nrecs; j++)
+			if (!strcmp(recs[j].name, tracefiles[i]) &&
+				!strcmp(recs[j].allocator, allocator))
+				b = &recs[j];
+		if (b == NULL || !b->valid)
+			continue;
+
+		if (!stats[i].valid)
+		{
+			printf("REGRESSION [%s %s]: trace is no longer valid\n",
+				   allocator, tracefiles[i]);
+			regressions++;
+			continue;
+		}
+		if (!strcmp(allocator, "mm") && stats[i].util < b->util - UTIL_EPSILON)
+		{
+			printf("REGRESSION [%s %s]: util %.1f%% -> %.1f%%\n",
+				   allocator, tracefiles[i], b->util * 100.0,
+				   stats[i].util * 100.0);
+			regressions++;
+		}
+		if (!strcmp(allocator, "mm") &&
+			stats[i].util_avg < b->util_avg - UTIL_EPSILON)
+		{
+			printf("REGRESSION [%s %s]: time-averaged util %.1f%% -> %.1f%%\n",
+				   allocator, tracefiles[i], b->util_avg * 100.0,
+				   stats[i].util_avg * 100.0);
+			regressions++;
+		}
+		if (thru_regressed(b, &stats[i], noise, alpha, &t))
+		{
+			printf("REGRESSION [%s %s]: Kops %.0f -> %.0f",
+				   allocator, tracefiles[i], b->kops, kops(&stats[i]));
+			if (t > 0)
+				printf(" (t = %.2f)", t);
+			printf("\n");
+			regressions++;
+		}
+	}
+	return regressions;
+}
+
+/*
+ * report_compare - flag regressions against a saved baseline. The
+ *     throughput of each trace is tested at THRU_ALPHA over the number
+ *     of tests (Bonferroni), so that THRU_ALPHA bounds the chance of
+ *     flagging any trace of an unchanged build.
+ */
+int report_compare(char *basefile, char **tracefiles, int n,
+				   stats_t *mm_stats, stats_t *libc_stats, double noise)
+{
+	base_t *recs;
+	int nrecs, regressions;
+	double alpha = THRU_ALPHA / (libc_stats ? 2 * n : n);
+
+	if ((recs = read_baseline(basefile, &nrecs)) == NULL)
+		return -1;
+	regressions = compare_traces("mm", tracefiles, n, mm_stats, recs, nrecs,
+								 noise, alpha);
+	if (libc_stats)
+		regressions += compare_traces("libc", tracefiles, n, libc_stats,
+									  recs, nrecs, noise, alpha);
+	free(recs);
+	return regressions;
+}
@@ -0,0 +1,29 @@
+/*
+ * report.h - machine-readable output of the driver results and
+ *            comparison against a saved baseline
+ */
+#ifndef __REPORT_H_
+#define __REPORT_H_
+
+#include <stdio.h>
+#include "stats.h"
+
+/* Write the per-trace results for mm (and libc, if not NULL) as JSON */
+void report_json(FILE *fp, char **tracefiles, int n,
+				 stats_t *mm_stats, stats_t *libc_stats, double perfindex);
+
+/* Write the same results as CSV, one row per allocator and trace */
+void report_csv(FILE *fp, char **tracefiles, int n,
+				stats_t *mm_stats, stats_t *libc_stats);
+
+/*
+ * Compare the results against a JSON file written earlier by
+ * report_json. noise is the relative spread of the throughput between
+ * separate runs of the driver, assumed when neither side was timed in
+ * separate processes (--procs). Returns the number of regressions
+ * found, or -1 if the baseline could not be read.
+ */
+int report_compare(char *basefile, char **tracefiles, int n,
+				   stats_t *mm_stats, stats_t *libc_stats, double noise);
+
+#endif /* __REPORT_H_ */
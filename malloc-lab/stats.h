@@ -0,0 +1,60 @@
+/*
+ * stats.h - per-trace statistics shared by the driver and its reporters
+ */
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#include <stddef.h>
+#include "perfctr.h"
+
+/* Summarizes the important stats for some malloc function on some trace */
+typedef struct
+{
+	/* defined for both libc malloc and student malloc package (mm.c) */
+	double ops;	 /* number of ops (malloc/free/realloc) in the trace */
+	int valid;	 /* was the trace processed correctly by the allocator? */
+	double secs; /* number of secs needed to run the trace (mean of runs) */
+
+	/* breakdown of ops by request type */
+	int allocs;	  /* number of malloc requests */
+	int frees;	  /* number of free requests */
+	int reallocs; /* number of realloc requests */
+
+	/* mean cycles of one request of each type (one timed replay) */
+	double cyc_malloc;
+	double cyc_free;
+	double cyc_realloc;
+
+	/* spread of the throughput over repeated timing runs */
+	int runs;		/* number of timing runs (--runs) */
+	int procs;		/* number of processes they ran in (--procs) */
+	double kops_sd; /* sample std deviation of Kops/sec over the runs,
+					 * or of each process's mean if procs > 1 */
+
+	/* hardware events per op, if counted (-p); -1 if an event is missing */
+	int counted;
+	double perf[PERF_NCOUNTERS];
+
+	/* defined only for the student malloc package */
+	double util; /* space utilization for this trace (always 0 for libc) */
+	size_t heap; /* peak heap size in bytes after the utilization pass */
+
+	/* how the heap tracked the live bytes over the whole trace */
+	double util_avg; /* mean of live bytes / heap bytes after each op */
+	size_t live;	 /* peak live payload bytes */
+	size_t trimmed;	 /* heap size after mm_trim before the final frees */
+	long sbrks;		 /* mem_sbrk calls during the trace */
+
+	/* cycles per mm_malloc/mm_free, if checked against a bound (-L):
+	 * percentiles of each op's fastest time over the runs, and the
+	 * slowest time seen at all */
+	int lat_ops;	/* number of timed ops */
+	double lat_p50; /* median */
+	double lat_p99; /* 99th percentile */
+	double lat_max; /* slowest op */
+	double lat_worst; /* slowest single timing of any op in any run */
+
+	/* Note: secs and util are only defined if valid is true */
+} stats_t;
+
+#endif /* __STATS_H_ */
@@ -0,0 +1,177 @@
+/*
+ * trace.c - read malloc lab trace files, shared by all the drivers
+ *
+ * Besides the requests themselves, read_trace numbers the requests on
+ * each id (seq) and notes the thread tag in force for each request, so
+ * that mtdriver can split a trace into streams without another pass.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "trace.h"
+
+#define MAXLINE 1024 /* max string size */
+
+static char msg[2 * MAXLINE]; /* for error messages, which quote a path */
+
+/*
+ * read_trace - read a trace file and store it in memory
+ */
+trace_t *read_trace(char *tracedir, char *filename)
+{
+	FILE *tracefile;
+	trace_t *trace;
+	char type[MAXLINE];
+	char path[MAXLINE];
+	char rest[MAXLINE];
+	unsigned index, size, hint, tid = 0;
+	unsigned max_tid = 0;
+	int tagged = 0;
+	int op_index = 0;
+	int *seq;
+
+	/* Allocate the trace record */
+	if ((trace = (trace_t *)malloc(sizeof(trace_t))) == NULL)
+		unix_error("malloc 1 failed in read_trace");
+
+	/* Read the trace file header */
+	snprintf(path, sizeof(path), "%s%s", tracedir, filename);
+	if ((tracefile = fopen(path, "r")) == NULL)
+	{
+		snprintf(msg, sizeof(msg), "Could not open %s in read_trace", path);
+		unix_error(msg);
+	}
+	if (fscanf(tracefile, "%d %d %d %d", &trace->sugg_heapsize,
+			   &trace->num_ids, &trace->num_ops, &trace->weight) != 4 ||
+		trace->num_ids < 0 || trace->num_ops < 0)
+	{
+		snprintf(msg, sizeof(msg), "Bad header in tracefile %s", path);
+		app_error(msg);
+	}
+
+	/* We'll store each request line in the trace in this array */
+	if ((trace->ops =
+			 (traceop_t *)malloc(trace->num_ops * sizeof(traceop_t))) == NULL)
+		unix_error("malloc 2 failed in read_trace");
+
+	/* We'll keep an array of pointers to the allocated blocks here... */
+	if ((trace->blocks =
+			 (char **)calloc(trace->num_ids, sizeof(char *))) == NULL)
+		unix_error("malloc 3 failed in read_trace");
+
+	/* ... along with the corresponding byte sizes of each block */
+	if ((trace->block_sizes =
+			 (size_t *)calloc(trace->num_ids, sizeof(size_t))) == NULL)
+		unix_error("malloc 4 failed in read_trace");
+
+	if ((seq = (int *)calloc(trace->num_ids, sizeof(int))) == NULL)
+		unix_error("malloc 5 failed in read_trace");
+	trace->num_hints = 0;
+
+	/* read every request line in the trace file */
+	while (fscanf(tracefile, "%s", type) != EOF)
+	{
+		if (type[0] == 't') /* thread tag for the requests that follow */
+		{
+			fscanf(tracefile, "%u", &tid);
+			max_tid = (tid > max_tid) ? tid : max_tid;
+			tagged = 1;
+			continue;
+		}
+		if (op_index >= trace->num_ops)
+			break;
+		switch (type[0])
+		{
+		case 'a': /* the rest of the line holds the hint, if any */
+			fscanf(tracefile, "%u %u", &index, &size);
+			if (fgets(rest, sizeof(rest), tracefile) == NULL ||
+				sscanf(rest, "%u", &hint) != 1)
+				hint = 0;
+			trace->ops[op_index].type = ALLOC;
+			trace->ops[op_index].size = size;
+			trace->ops[op_index].hint = hint;
+			trace->num_hints += (hint != 0);
+			break;
+		case 'r':
+			fscanf(tracefile, "%u %u", &index, &size);
+			trace->ops[op_index].type = REALLOC;
+			trace->ops[op_index].size = size;
+			trace->ops[op_index].hint = 0;
+			break;
+		case 'f':
+			fscanf(tracefile, "%u", &index);
+			trace->ops[op_index].type = FREE;
+			trace->ops[op_index].size = 0;
+			trace->ops[op_index].hint = 0;
+			break;
+		default:
+			snprintf(msg, sizeof(msg), "Bogus type character (%c) in tracefile %s",
+					 type[0], path);
+			app_error(msg);
+		}
+		if (index >= trace->num_ids)
+		{
+			snprintf(msg, sizeof(msg), "Bad id %u in tracefile %s", index, path);
+			app_error(msg);
+		}
+		trace->ops[op_index].index = index;
+		trace->ops[op_index].tid = tid;
+		trace->ops[op_index].seq = seq[index]++;
+		op_index++;
+	}
+	fclose(tracefile);
+	free(seq);
+	if (op_index != trace->num_ops)
+	{
+		snprintf(msg, sizeof(msg), "Tracefile %s has %d requests, header says %d",
+				 path, op_index, trace->num_ops);
+		app_error(msg);
+	}
+	trace->num_tids = tagged ? max_tid + 1 : 0;
+
+	return trace;
+}
+
+/*
+ * free_trace - Free the trace record and the three arrays it points
+ *              to, all of which were allocated in read_trace().
+ */
+void free_trace(trace_t *trace)
+{
+	free(trace->ops); /* free the three arrays... */
+	free(trace->blocks);
+	free(trace->block_sizes);
+	free(trace); /* and the trace record itself... */
+}
+
+/*
+ * now - wall clock time in seconds
+ */
+double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+void app_error(char *msg)
+{
+	printf("%s\n", msg);
+	exit(1);
+}
+
+/*
+ * unix_error - Report a Unix-style error
+ */
+void unix_error(char *msg)
+{
+	printf("%s: %s\n", msg, strerror(errno));
+	exit(1);
+}
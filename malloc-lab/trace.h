@@ -0,0 +1,63 @@
+/*
+ * trace.h - read malloc lab trace files, shared by all the drivers
+ *
+ * A trace file starts with a header of four numbers (suggested heap
+ * size, number of ids, number of requests, weight), followed by one
+ * request per line: "a <id> <bytes>", "r <id> <bytes>" or "f <id>".
+ * An alloc line may end with a hint for mm_malloc_hint,
+ * "a <id> <bytes> <hint>". A line "t <tid>" tags the requests that
+ * follow it with a thread.
+ */
+#ifndef __TRACE_H_
+#define __TRACE_H_
+
+#include <stddef.h>
+
+/* Characterizes a single trace operation (allocator request) */
+typedef struct
+{
+	enum
+	{
+		ALLOC,
+		FREE,
+		REALLOC
+	} type;	   /* type of request */
+	int index; /* index for free() to use later */
+	int size;  /* byte size of alloc/realloc request */
+	int tid;   /* thread tag of the request (0 if untagged) */
+	int seq;   /* number of earlier requests on the same index */
+	unsigned int hint; /* mm_malloc_hint hint of an alloc (0 if none) */
+} traceop_t;
+
+/* Holds the information for one trace file */
+typedef struct
+{
+	int sugg_heapsize;	 /* suggested heap size (unused) */
+	int num_ids;		 /* number of alloc/realloc ids */
+	int num_ops;		 /* number of distinct requests */
+	int weight;			 /* weight for this trace (unused) */
+	int num_tids;		 /* number of distinct thread tags (0 if untagged) */
+	int num_hints;		 /* number of allocs with a hint */
+	traceop_t *ops;		 /* array of requests */
+	char **blocks;		 /* array of ptrs returned by malloc/realloc... */
+	size_t *block_sizes; /* ... and a corresponding array of payload sizes */
+} trace_t;
+
+/*
+ * Read tracedir/filename into memory. The blocks and block_sizes
+ * arrays start out zeroed, for the driver to fill in as it replays.
+ * Exits with a message on a missing or malformed file.
+ */
+trace_t *read_trace(char *tracedir, char *filename);
+
+/* Free the trace record and the arrays it points to */
+void free_trace(trace_t *trace);
+
+/* Wall clock time in seconds */
+double now(void);
+
+/* Report an error (and errno, for unix_error) and exit */
+void app_error(char *msg) __attribute__((noreturn));
+void unix_error(char *msg) __attribute__((noreturn));
+
+#endif /* __TRACE_H_ */
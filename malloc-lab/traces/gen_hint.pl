@@ -0,0 +1,70 @@
+#!/usr/bin/perl
+
+# Hinted trace: request handlers allocate a burst of small objects
+# that all die together at the end of the request, tagged with hint 1
+# ("a <id> <bytes> 1"). Between them the handlers add entries to a
+# long-lived cache, without a hint, which evicts a random entry once
+# it is full. Every few requests a handler allocates larger buffers,
+# which need the space the earlier bursts left behind.
+
+$out_filename = "hint.rep";
+$num_requests = 200;
+$min_objects = 50;
+$max_objects = 300;
+$cache_pct = 5;
+$cache_max = 2000;
+$big_every = 8;
+
+srand(15213);
+
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+@ops = ();
+@cache = ();
+$blk = 0;
+
+for ($req = 0; $req < $num_requests; $req += 1) {
+	@burst = ();
+	$n = $min_objects + int(rand($max_objects - $min_objects + 1));
+	for ($i = 0; $i < $n; $i += 1) {
+		if ($req % $big_every == $big_every - 1) {
+			$size = 512 + int(rand(1537));
+			push @ops, "a $blk $size";
+		} else {
+			$size = 16 + int(rand(113));
+			push @ops, "a $blk $size 1";
+		}
+		push @burst, $blk;
+		$blk += 1;
+
+		if (rand(100) < $cache_pct) {
+			$size = 16 + int(rand(113));
+			push @ops, "a $blk $size";
+			push @cache, $blk;
+			$blk += 1;
+			if (scalar(@cache) > $cache_max) {
+				$j = int(rand(scalar(@cache)));
+				push @ops, "f $cache[$j]";
+				$cache[$j] = $cache[$#cache];
+				pop @cache;
+			}
+		}
+	}
+	foreach $b (@burst) {
+		push @ops, "f $b";
+	}
+}
+
+foreach $b (@cache) {
+	push @ops, "f $b";
+}
+
+$num_ops = scalar(@ops);
+
+print OUTFILE "0\n";
+print OUTFILE "$blk\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+print OUTFILE join("\n", @ops);
+
+close OUTFILE;
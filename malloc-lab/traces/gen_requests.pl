@@ -0,0 +1,61 @@
+#!/usr/bin/perl
+
+# Request-shaped trace: each request handler allocates a burst of
+# short-lived objects, grows a few of them, and frees all of them
+# before the next request starts (see arenadriver.c)
+
+$out_filename = "requests.rep";
+$num_requests = 200;
+$min_objects = 20;
+$max_objects = 200;
+$realloc_pct = 5;
+
+srand(15213);
+
+# Object sizes: mostly small, some medium buffers, a few large ones
+sub object_size {
+	my $r = rand(100);
+	return 16 + int(rand(241)) if ($r < 90);
+	return 256 + int(rand(1793)) if ($r < 99);
+	return 4096 + int(rand(28673));
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+@ops = ();
+$blk = 0;
+
+for ($req = 0; $req < $num_requests; $req += 1) {
+	$first = $blk;
+	$n = $min_objects + int(rand($max_objects - $min_objects + 1));
+	for ($i = 0; $i < $n; $i += 1) {
+		$size = object_size();
+		push @ops, "a $blk $size";
+		if (rand(100) < $realloc_pct) {
+			$size = int($size * (1.5 + rand(1.5)));
+			push @ops, "r $blk $size";
+		}
+		$blk += 1;
+	}
+
+	# Free the whole request, in random order
+	@ids = ($first .. $blk - 1);
+	for ($i = $#ids; $i > 0; $i -= 1) {
+		$j = int(rand($i + 1));
+		@ids[$i, $j] = @ids[$j, $i];
+	}
+	foreach $id (@ids) {
+		push @ops, "f $id";
+	}
+}
+
+$num_ops = scalar(@ops);
+
+print OUTFILE "0\n";
+print OUTFILE "$blk\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+print OUTFILE join("\n", @ops);
+
+close OUTFILE;
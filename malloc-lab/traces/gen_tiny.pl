@@ -0,0 +1,55 @@
+#!/usr/bin/perl
+
+# Tiny-object trace: mostly 1-8 byte objects (small list nodes, boxed
+# integers), allocated and freed in random order around a live set of
+# a few thousand, with an occasional 16-64 byte one mixed in. The
+# minimum block size of the allocator dominates the utilization.
+
+$out_filename = "tiny.rep";
+$num_blocks = 8000;
+$max_live = 3000;
+
+srand(15213);
+
+sub object_size {
+	return 1 + int(rand(8)) if (rand(100) < 90);
+	return 16 + int(rand(49));
+}
+
+# Open output file
+open OUTFILE, ">$out_filename" or die "Cannot create $out_filename\n";
+
+@ops = ();
+@live = ();
+
+for ($blk = 0; $blk < $num_blocks; $blk += 1) {
+	$size = object_size();
+	push @ops, "a $blk $size";
+	push @live, $blk;
+
+	# Past the live limit, free a random live object for each new one
+	if (scalar(@live) > $max_live) {
+		$i = int(rand(scalar(@live)));
+		push @ops, "f $live[$i]";
+		$live[$i] = $live[$#live];
+		pop @live;
+	}
+}
+
+# Free whatever is left, in random order
+while (scalar(@live) > 0) {
+	$i = int(rand(scalar(@live)));
+	push @ops, "f $live[$i]";
+	$live[$i] = $live[$#live];
+	pop @live;
+}
+
+$num_ops = scalar(@ops);
+
+print OUTFILE "0\n";
+print OUTFILE "$num_blocks\n";
+print OUTFILE "$num_ops\n";
+print OUTFILE "1\n";
+print OUTFILE join("\n", @ops);
+
+close OUTFILE;
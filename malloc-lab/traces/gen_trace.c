@@ -0,0 +1,480 @@
+/*
+ * gen_trace.c - parameterized synthetic trace generator
+ *
+ * Generates a balanced trace in the format described in README from
+ * a sequence of phases. Each phase has its own size distribution,
+ * lifetime distribution and realloc pattern; options apply to the
+ * phase being built, and each -n closes it:
+ *
+ *   gen_trace -s 1 -z uniform:16:256 -l exp:200 -n 1000000 \
+ *             -z lognormal:7:1.5 -l exp:5000 -r 0.1:1.5 -n 500000 \
+ *             -T 4 -o phased.rep
+ *
+ * Lifetimes are counted in requests: a block with lifetime L is freed
+ * about L requests after it was allocated. Blocks still live at the
+ * end of the last phase are freed in allocation order. With -T, each
+ * block is owned by a random thread that makes all of its requests,
+ * and the trace carries "t <tid>" tags. The same seed always gives
+ * the same trace.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#define MAXPHASES 64	   /* max number of -n phases */
+#define MAXSIZE (1 << 30) /* largest request size generated */
+#define DEFAULT_OPS 100000 /* requests in a phase if -n is never given */
+
+/* Distributions of request sizes and lifetimes */
+typedef enum
+{
+	D_FIXED,
+	D_UNIFORM,
+	D_EXP,
+	D_LOGNORMAL,
+	D_POWERLAW,
+	D_EMPIRICAL,
+	D_FOREVER
+} dkind_t;
+
+typedef struct
+{
+	dkind_t kind;
+	double a, b, c;	   /* parameters, see usage() */
+	int nvals;		   /* D_EMPIRICAL: number of samples in vals */
+	int *vals;		   /* D_EMPIRICAL: sizes seen in the source trace */
+} dist_t;
+
+typedef struct
+{
+	long ops;		  /* requests in this phase */
+	dist_t size;	  /* request sizes */
+	dist_t life;	  /* lifetimes in requests */
+	double realloc_p; /* probability that a request is a realloc */
+	double growth;	  /* realloc size factor */
+} phase_t;
+
+/* A live block */
+typedef struct
+{
+	int size;
+	int tid;
+	int slot; /* index in the live array */
+} block_t;
+
+/* An entry in the min-heap of scheduled frees */
+typedef struct
+{
+	long death; /* request number when the block is freed */
+	int id;
+} event_t;
+
+/* Output buffer; the header can only be written once the ops are known */
+static char *out;
+static size_t outlen, outcap;
+
+static block_t *blocks;	 /* indexed by id */
+static int nblocks, maxblocks;
+static int *live;		 /* ids of the live blocks */
+static int nlive;
+static event_t *heap;	 /* scheduled frees, min-heap on death */
+static int nheap, maxheap;
+
+static unsigned long long rng_state;
+static int cur_tid = 0;
+static long num_ops = 0;
+static long live_bytes = 0, peak_bytes = 0;
+
+static void usage(void);
+
+/*
+ * die - report an error and exit
+ */
+static void die(char *msg, char *arg)
+{
+	fprintf(stderr, "gen_trace: %s%s%s\n", msg, arg ? ": " : "", arg ? arg : "");
+	exit(1);
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+	if ((p = realloc(p, size)) == NULL)
+		die("out of memory", NULL);
+	return p;
+}
+
+/*****************************************************
+ * Seeded random numbers (splitmix64), the same on all
+ * platforms so a seed always gives the same trace
+ ****************************************************/
+
+static unsigned long long rnd64(void)
+{
+	unsigned long long z = (rng_state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* uniform in [0, 1) */
+static double rnd(void)
+{
+	return (rnd64() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* standard normal, Box-Muller */
+static double rnd_normal(void)
+{
+	double u = 1.0 - rnd(), v = rnd();
+
+	return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/*
+ * sample - draw one value from a distribution
+ */
+static double sample(dist_t *d)
+{
+	double u, lo, hi, x;
+
+	switch (d->kind)
+	{
+	case D_FIXED:
+		return d->a;
+	case D_UNIFORM:
+		return d->a + floor(rnd() * (d->b - d->a + 1));
+	case D_EXP:
+		return -d->a * log(1.0 - rnd());
+	case D_LOGNORMAL:
+		x = exp(d->a + d->b * rnd_normal());
+		return (d->c > 0 && x > d->c) ? d->c : x;
+	case D_POWERLAW:
+		/* Pareto with exponent a, truncated to [b, c] */
+		u = rnd();
+		lo = pow(d->b, -d->a);
+		hi = pow(d->c, -d->a);
+		return pow(lo - u * (lo - hi), -1.0 / d->a);
+	case D_EMPIRICAL:
+		return d->vals[rnd64() % d->nvals];
+	case D_FOREVER:
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * read_empirical - collect the request sizes of an existing trace.
+ *     Sampling uniformly from them reproduces its size histogram.
+ */
+static void read_empirical(dist_t *d, char *path)
+{
+	FILE *fp;
+	char line[256];
+	int id, size, cap = 0, header = 4;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		die("could not open empirical trace", path);
+	d->nvals = 0;
+	d->vals = NULL;
+	while (fgets(line, sizeof(line), fp))
+	{
+		if (header > 0)
+		{
+			header--;
+			continue;
+		}
+		if ((line[0] == 'a' || line[0] == 'r') &&
+			sscanf(line + 1, "%d %d", &id, &size) == 2)
+		{
+			if (d->nvals == cap)
+			{
+				cap = cap ? 2 * cap : 1024;
+				d->vals = xrealloc(d->vals, cap * sizeof(int));
+			}
+			d->vals[d->nvals++] = size;
+		}
+	}
+	fclose(fp);
+	if (d->nvals == 0)
+		die("no requests in empirical trace", path);
+}
+
+/*
+ * parse_dist - parse "name:p1:p2:p3" into a distribution
+ */
+static void parse_dist(dist_t *d, char *spec, int is_size)
+{
+	char *name = strdup(spec), *params;
+	int n = 0;
+
+	if ((params = strchr(name, ':')) != NULL)
+	{
+		*params++ = '\0';
+		if (strcmp(name, "empirical") != 0)
+			n = sscanf(params, "%lf:%lf:%lf", &d->a, &d->b, &d->c);
+	}
+	d->c = (n >= 3) ? d->c : 0;
+
+	if (!strcmp(name, "fixed") && n == 1)
+		d->kind = D_FIXED;
+	else if (!strcmp(name, "uniform") && n == 2 && d->a <= d->b)
+		d->kind = D_UNIFORM;
+	else if (!strcmp(name, "exp") && n == 1 && d->a > 0)
+		d->kind = D_EXP;
+	else if (!strcmp(name, "lognormal") && n >= 2)
+		d->kind = D_LOGNORMAL;
+	else if (!strcmp(name, "powerlaw") && n == 3 && d->a > 0 &&
+			 d->b > 0 && d->b < d->c)
+		d->kind = D_POWERLAW;
+	else if (is_size && !strcmp(name, "empirical") && params)
+	{
+		d->kind = D_EMPIRICAL;
+		read_empirical(d, params);
+	}
+	else if (!is_size && !strcmp(name, "forever"))
+		d->kind = D_FOREVER;
+	else
+		die(is_size ? "bad size distribution" : "bad lifetime distribution",
+			spec);
+	free(name);
+}
+
+/*****************************************************
+ * Output
+ ****************************************************/
+
+/*
+ * emit - append one request made by thread tid; size < 0 for frees
+ */
+static void emit(int tid, char type, int id, int size)
+{
+	if (outcap - outlen < 64)
+	{
+		outcap = outcap ? 2 * outcap : (1 << 20);
+		out = xrealloc(out, outcap);
+	}
+	if (tid != cur_tid)
+	{
+		outlen += sprintf(out + outlen, "t %d\n", tid);
+		cur_tid = tid;
+	}
+	if (size < 0)
+		outlen += sprintf(out + outlen, "%c %d\n", type, id);
+	else
+		outlen += sprintf(out + outlen, "%c %d %d\n", type, id, size);
+	num_ops++;
+}
+
+/*****************************************************
+ * Live blocks and the min-heap of scheduled frees
+ ****************************************************/
+
+static void heap_push(long death, int id)
+{
+	int i, parent;
+
+	if (nheap == maxheap)
+	{
+		maxheap = maxheap ? 2 * maxheap : 1024;
+		heap = xrealloc(heap, maxheap * sizeof(event_t));
+	}
+	for (i = nheap++; i > 0; i = parent)
+	{
+		parent = (i - 1) / 2;
+		if (heap[parent].death <= death)
+			break;
+		heap[i] = heap[parent];
+	}
+	heap[i].death = death;
+	heap[i].id = id;
+}
+
+static event_t heap_pop(void)
+{
+	event_t top = heap[0], last = heap[--nheap];
+	int i = 0, child;
+
+	while ((child = 2 * i + 1) < nheap)
+	{
+		if (child + 1 < nheap && heap[child + 1].death < heap[child].death)
+			child++;
+		if (last.death <= heap[child].death)
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return top;
+}
+
+static void do_alloc(phase_t *ph, long now, int nthreads)
+{
+	block_t *b;
+	double life;
+	int id = nblocks++;
+
+	if (nblocks > maxblocks)
+	{
+		maxblocks = maxblocks ? 2 * maxblocks : 1024;
+		blocks = xrealloc(blocks, maxblocks * sizeof(block_t));
+		live = xrealloc(live, maxblocks * sizeof(int));
+	}
+	b = &blocks[id];
+	b->size = (int)fmin(fmax(sample(&ph->size), 1), MAXSIZE);
+	b->tid = (nthreads > 1) ? (int)(rnd64() % nthreads) : 0;
+	b->slot = nlive;
+	live[nlive++] = id;
+	emit(b->tid, 'a', id, b->size);
+
+	live_bytes += b->size;
+	if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+	if ((life = sample(&ph->life)) >= 0)
+		heap_push(now + 1 + (long)life, id);
+}
+
+static void do_free(int id)
+{
+	block_t *b = &blocks[id];
+
+	emit(b->tid, 'f', id, -1);
+	live_bytes -= b->size;
+	live[b->slot] = live[--nlive];
+	blocks[live[b->slot]].slot = b->slot;
+	b->slot = -1;
+}
+
+static void do_realloc(phase_t *ph)
+{
+	int id = live[rnd64() % nlive];
+	block_t *b = &blocks[id];
+	int size = (int)fmin(fmax(b->size * ph->growth, 1), MAXSIZE);
+
+	emit(b->tid, 'r', id, size);
+	live_bytes += size - b->size;
+	if (live_bytes > peak_bytes)
+		peak_bytes = live_bytes;
+	b->size = size;
+}
+
+/*
+ * run_phase - generate ph->ops requests. A request frees the next
+ *     block that is due, or else is a realloc with probability
+ *     realloc_p, or else allocates a new block.
+ */
+static void run_phase(phase_t *ph, int nthreads)
+{
+	long start = num_ops;
+	event_t ev;
+
+	while (num_ops - start < ph->ops)
+	{
+		if (nheap > 0 && heap[0].death <= num_ops)
+		{
+			ev = heap_pop();
+			do_free(ev.id);
+		}
+		else if (nlive > 0 && rnd() < ph->realloc_p)
+			do_realloc(ph);
+		else
+			do_alloc(ph, num_ops, nthreads);
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: gen_trace [options] [-o <file>]\n");
+	fprintf(stderr, "Phase options (apply to the phase closed by the next -n):\n");
+	fprintf(stderr, "\t-z <dist>    Request sizes (default uniform:1:4096):\n");
+	fprintf(stderr, "\t               fixed:<n>, uniform:<lo>:<hi>,\n");
+	fprintf(stderr, "\t               lognormal:<mu>:<sigma>[:<max>] (of ln size),\n");
+	fprintf(stderr, "\t               powerlaw:<alpha>:<min>:<max>,\n");
+	fprintf(stderr, "\t               empirical:<trace file>\n");
+	fprintf(stderr, "\t-l <dist>    Lifetimes in requests (default exp:1000):\n");
+	fprintf(stderr, "\t               fixed, uniform, exp:<mean>, lognormal,\n");
+	fprintf(stderr, "\t               powerlaw as above, or forever\n");
+	fprintf(stderr, "\t-r <p>:<f>   Make a request a realloc of a random live\n");
+	fprintf(stderr, "\t               block with probability p, scaling it by f\n");
+	fprintf(stderr, "\t-n <ops>     Close the phase after <ops> requests\n");
+	fprintf(stderr, "Global options:\n");
+	fprintf(stderr, "\t-s <seed>    Random seed (default 1)\n");
+	fprintf(stderr, "\t-T <n>       Spread the blocks over n threads (t tags)\n");
+	fprintf(stderr, "\t-o <file>    Output file (default stdout)\n");
+	fprintf(stderr, "\t-h           Print this message\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	phase_t phases[MAXPHASES], cur;
+	int nphases = 0, nthreads = 1, i, c;
+	char *outfile = NULL;
+	FILE *fp = stdout;
+
+	memset(&cur, 0, sizeof(cur));
+	parse_dist(&cur.size, "uniform:1:4096", 1);
+	parse_dist(&cur.life, "exp:1000", 0);
+	rng_state = 1;
+
+	while ((c = getopt(argc, argv, "z:l:r:n:s:T:o:h")) != EOF)
+	{
+		switch (c)
+		{
+		case 'z':
+			parse_dist(&cur.size, optarg, 1);
+			break;
+		case 'l':
+			parse_dist(&cur.life, optarg, 0);
+			break;
+		case 'r':
+			if (sscanf(optarg, "%lf:%lf", &cur.realloc_p, &cur.growth) != 2 ||
+				cur.realloc_p < 0 || cur.realloc_p >= 1 || cur.growth <= 0)
+				die("bad realloc pattern", optarg);
+			break;
+		case 'n':
+			if (nphases == MAXPHASES)
+				die("too many phases", NULL);
+			if ((cur.ops = atol(optarg)) <= 0)
+				die("bad number of requests", optarg);
+			phases[nphases++] = cur;
+			break;
+		case 's':
+			rng_state = strtoull(optarg, NULL, 0);
+			break;
+		case 'T':
+			if ((nthreads = atoi(optarg)) < 1)
+				die("bad number of threads", optarg);
+			break;
+		case 'o':
+			outfile = optarg;
+			break;
+		case 'h':
+		default:
+			usage();
+		}
+	}
+	if (nphases == 0)
+	{
+		cur.ops = DEFAULT_OPS;
+		phases[nphases++] = cur;
+	}
+
+	for (i = 0; i < nphases; i++)
+		run_phase(&phases[i], nthreads);
+
+	/* Balance the trace: free whatever is still live, oldest first */
+	for (i = 0; i < nblocks; i++)
+		if (blocks[i].slot >= 0)
+			do_free(i);
+
+	if (outfile && (fp = fopen(outfile, "w")) == NULL)
+		die("could not create output file", outfile);
+	fprintf(fp, "%ld\n%d\n%ld\n1\n", peak_bytes + 100, nblocks, num_ops);
+	fwrite(out, 1, outlen, fp);
+	if (fp != stdout)
+		fclose(fp);
+	return 0;
+}